@@ -0,0 +1,315 @@
+#ifndef AUDIO_STREAM_HPP
+#define AUDIO_STREAM_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Ring_Buffer.hpp"
+
+//Define AUDIO_STREAM_NO_RTAUDIO to build without the RtAudio library, leaving only the null device//
+#ifndef AUDIO_STREAM_NO_RTAUDIO
+#include "third_party/RtAudio.h"
+#endif
+
+//Real-time host for a fillBuffer style renderer - A compute thread renders blocks ahead into a lock-free ring buffer, which the audio callback drains.//
+//The callback never blocks or renders. If the ring runs dry it plays silence and counts an underrun.//
+//The null device plays into memory from its own thread, ticking at the sample-rate clock, so streams can be tested without sound hardware.//
+class Audio_Stream
+{
+public:
+	//Matches FDTD_Accelerated::fillBuffer(input, output, numSteps)//
+	typedef std::function<void(float*, float*, uint32_t)> Render_Callback;
+private:
+	static const uint32_t impulseLength_ = 5;
+
+	Render_Callback render_;
+	uint32_t sampleRate_;
+	uint32_t blockSize_;
+	uint32_t blocksAhead_;
+	bool isNullDevice_;
+	bool isNullDeviceActive_ = false;
+
+	Ring_Buffer<float> ringBuffer_;
+	std::vector<float> inputBlock_;
+	std::vector<float> outputBlock_;
+	std::vector<float> deviceBlock_;		//Null device's output buffer//
+	std::vector<float> recording_;			//Everything the device played, up to its preallocated length//
+	uint32_t numRecorded_ = 0;
+
+	std::thread computeThread_;
+	std::thread nullDeviceThread_;
+	std::atomic<bool> isRunning_;
+	std::atomic<float> pendingExcitation_;
+
+	std::atomic<uint64_t> numUnderruns_;
+	std::atomic<uint64_t> numDeadlineMisses_;
+	std::atomic<uint64_t> numBlocksRendered_;
+	std::atomic<uint64_t> numFramesPlayed_;
+	double maxComputeTime_ = 0.0;
+	double totalComputeTime_ = 0.0;
+
+#ifndef AUDIO_STREAM_NO_RTAUDIO
+	std::unique_ptr<RtAudio> dac_;
+#endif
+
+	double blockPeriod() const
+	{
+		return (double)blockSize_ / (double)sampleRate_;
+	}
+	void computeLoop()
+	{
+		const uint32_t targetLatency = blockSize_ * blocksAhead_;
+		const std::chrono::duration<double> idlePeriod(blockPeriod() / 4.0);
+		while (isRunning_.load(std::memory_order_acquire))
+		{
+			//Stay at most blocksAhead blocks ahead of the callback, so latency is bounded by the setting rather than the ring's capacity//
+			if (ringBuffer_.available() + blockSize_ > targetLatency)
+			{
+				std::this_thread::sleep_for(idlePeriod);
+				continue;
+			}
+
+			float excitation = pendingExcitation_.exchange(0.0f);
+			if (excitation != 0.0f)
+				std::fill(inputBlock_.begin(), inputBlock_.begin() + std::min(impulseLength_, blockSize_), excitation);
+
+			std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+			render_(inputBlock_.data(), outputBlock_.data(), blockSize_);
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::fill(inputBlock_.begin(), inputBlock_.end(), 0.0f);
+
+			//A block taking longer than it lasts can't keep up, however far ahead the ring is//
+			if (elapsed > blockPeriod())
+				++numDeadlineMisses_;
+			maxComputeTime_ = elapsed > maxComputeTime_ ? elapsed : maxComputeTime_;
+			totalComputeTime_ += elapsed;
+
+			ringBuffer_.push(outputBlock_.data(), blockSize_);
+			++numBlocksRendered_;
+		}
+	}
+	void nullDeviceLoop()
+	{
+		//Deadlines are taken from the stream start rather than the last wake, so oversleeping doesn't drift the clock//
+		std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+		for (uint64_t tick = 1; isRunning_.load(std::memory_order_acquire); ++tick)
+		{
+			std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(tick * blockPeriod())));
+			playBlock(deviceBlock_.data(), blockSize_);
+		}
+	}
+	//Audio thread - Must not block, allocate or render//
+	void playBlock(float* aOutput, uint32_t aNumFrames)
+	{
+		uint32_t numRead = ringBuffer_.pop(aOutput, aNumFrames);
+		if (numRead != aNumFrames)
+		{
+			std::fill(aOutput + numRead, aOutput + aNumFrames, 0.0f);
+			++numUnderruns_;
+		}
+		numFramesPlayed_ += aNumFrames;
+
+		uint32_t numCopied = std::min(aNumFrames, (uint32_t)recording_.size() - numRecorded_);
+		std::copy(aOutput, aOutput + numCopied, recording_.begin() + numRecorded_);
+		numRecorded_ += numCopied;
+	}
+#ifndef AUDIO_STREAM_NO_RTAUDIO
+	static int audioCallback(void* aOutputBuffer, void*, unsigned int aNumFrames, double, RtAudioStreamStatus aStatus, void* aUserData)
+	{
+		Audio_Stream* stream = static_cast<Audio_Stream*>(aUserData);
+
+		//Driver side underflow - The callback itself was late, so the ring never got the chance to run dry//
+		if (aStatus & RTAUDIO_OUTPUT_UNDERFLOW)
+			++stream->numUnderruns_;
+
+		stream->playBlock(static_cast<float*>(aOutputBuffer), aNumFrames);
+		return 0;
+	}
+	bool openDevice()
+	{
+		try
+		{
+			dac_.reset(new RtAudio());
+			if (dac_->getDeviceCount() == 0)
+			{
+				std::cout << "Audio_Stream: No audio devices found, falling back to the null device" << std::endl;
+				return false;
+			}
+
+			RtAudio::StreamParameters parameters;
+			parameters.deviceId = dac_->getDefaultOutputDevice();
+			parameters.nChannels = 1;
+			unsigned int bufferFrames = blockSize_;
+			dac_->openStream(&parameters, nullptr, RTAUDIO_FLOAT32, sampleRate_, &bufferFrames, &Audio_Stream::audioCallback, this);
+			if (bufferFrames != blockSize_)
+				std::cout << "Audio_Stream: Device uses " << bufferFrames << " frame buffers, rendering in blocks of " << blockSize_ << std::endl;
+			dac_->startStream();
+		}
+		catch (RtAudioError& e)
+		{
+			std::cout << "Audio_Stream: " << e.getMessage() << ", falling back to the null device" << std::endl;
+			closeDevice();
+			return false;
+		}
+		return true;
+	}
+	void closeDevice()
+	{
+		if (!dac_)
+			return;
+		try
+		{
+			if (dac_->isStreamRunning())
+				dac_->stopStream();
+			if (dac_->isStreamOpen())
+				dac_->closeStream();
+		}
+		catch (RtAudioError& e)
+		{
+			std::cout << "Audio_Stream: " << e.getMessage() << std::endl;
+		}
+		dac_.reset();
+	}
+#endif
+public:
+	//aBlocksAhead is how many blocks the compute thread may render ahead of playback - Each adds one block of latency//
+	//aIsNullDevice plays into memory at the sample-rate clock instead of opening the default output device//
+	Audio_Stream(Render_Callback aRender, uint32_t aSampleRate, uint32_t aBlockSize, uint32_t aBlocksAhead, bool aIsNullDevice) :
+		render_(aRender),
+		sampleRate_(aSampleRate),
+		blockSize_(aBlockSize),
+		blocksAhead_(aBlocksAhead == 0 ? 1 : aBlocksAhead),
+		isNullDevice_(aIsNullDevice),
+		ringBuffer_(aBlockSize * (aBlocksAhead == 0 ? 1 : aBlocksAhead)),
+		inputBlock_(aBlockSize, 0.0f),
+		outputBlock_(aBlockSize, 0.0f),
+		deviceBlock_(aBlockSize, 0.0f),
+		isRunning_(false),
+		pendingExcitation_(0.0f),
+		numUnderruns_(0),
+		numDeadlineMisses_(0),
+		numBlocksRendered_(0),
+		numFramesPlayed_(0)
+	{
+	}
+	~Audio_Stream()
+	{
+		stop();
+	}
+
+	//Renders until the ring holds blocksAhead blocks, then starts playback//
+	void start()
+	{
+		stop();
+		ringBuffer_.clear();
+		numUnderruns_ = 0;
+		numDeadlineMisses_ = 0;
+		numBlocksRendered_ = 0;
+		numFramesPlayed_ = 0;
+		numRecorded_ = 0;
+		maxComputeTime_ = 0.0;
+		totalComputeTime_ = 0.0;
+
+		isRunning_.store(true, std::memory_order_release);
+		computeThread_ = std::thread(&Audio_Stream::computeLoop, this);
+		while (numBlocksRendered_.load() < blocksAhead_)
+			std::this_thread::yield();
+
+		isNullDeviceActive_ = isNullDevice_;
+#ifndef AUDIO_STREAM_NO_RTAUDIO
+		if (!isNullDevice_)
+			isNullDeviceActive_ = !openDevice();
+#else
+		isNullDeviceActive_ = true;
+#endif
+		if (isNullDeviceActive_)
+			nullDeviceThread_ = std::thread(&Audio_Stream::nullDeviceLoop, this);
+	}
+	void stop()
+	{
+		if (!isRunning_.load())
+			return;
+
+#ifndef AUDIO_STREAM_NO_RTAUDIO
+		closeDevice();
+#endif
+		isRunning_.store(false, std::memory_order_release);
+		if (nullDeviceThread_.joinable())
+			nullDeviceThread_.join();
+		if (computeThread_.joinable())
+			computeThread_.join();
+	}
+	//Streams for aSeconds of wall clock time//
+	void run(double aSeconds)
+	{
+		start();
+		std::this_thread::sleep_for(std::chrono::duration<double>(aSeconds));
+		stop();
+	}
+
+	//Adds an impulse of height aAmplitude to the next block rendered. Safe from any thread//
+	void excite(float aAmplitude)
+	{
+		pendingExcitation_.store(aAmplitude);
+	}
+	//Keeps the first aLength samples played, for writing out once the stream stops. Set before start()//
+	void setRecording(uint32_t aLength)
+	{
+		recording_.assign(aLength, 0.0f);
+		numRecorded_ = 0;
+	}
+	const float* getRecording() const
+	{
+		return recording_.data();
+	}
+	uint32_t getRecordingLength() const
+	{
+		return numRecorded_;
+	}
+
+	//Callbacks that found fewer samples in the ring than they needed, including driver reported underflows//
+	uint64_t getUnderruns() const
+	{
+		return numUnderruns_.load();
+	}
+	//Blocks whose render took longer than blockSize / sampleRate//
+	uint64_t getDeadlineMisses() const
+	{
+		return numDeadlineMisses_.load();
+	}
+	uint64_t getBlocksRendered() const
+	{
+		return numBlocksRendered_.load();
+	}
+	uint64_t getFramesPlayed() const
+	{
+		return numFramesPlayed_.load();
+	}
+	//Render times in ms, valid once the stream has stopped//
+	double getMaxComputeTime() const
+	{
+		return maxComputeTime_ * 1000.0;
+	}
+	double getAverageComputeTime() const
+	{
+		return numBlocksRendered_.load() != 0 ? totalComputeTime_ * 1000.0 / numBlocksRendered_.load() : 0.0;
+	}
+	//Latency added by rendering ahead, in ms//
+	double getLatency() const
+	{
+		return blockPeriod() * blocksAhead_ * 1000.0;
+	}
+	bool isNullDevice() const
+	{
+		return isNullDeviceActive_;
+	}
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef AUTOMATION_STREAM_HPP
+#define AUTOMATION_STREAM_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+//One coefficient's value against the engine's sample clock - Breakpoint ramps, linear between (sample, value) points, or dense values, one per sample.//
+//Either holds its first value before it starts and its last after it ends//
+class Automation_Stream
+{
+private:
+	std::vector<std::pair<uint64_t, float>> breakpoints_;	//Sorted by sample//
+	std::vector<float> values_;
+	uint64_t start_ = 0;									//Sample of values_[0]//
+public:
+	static Automation_Stream ramp(std::vector<std::pair<uint64_t, float>> aBreakpoints)
+	{
+		Automation_Stream stream;
+		std::stable_sort(aBreakpoints.begin(), aBreakpoints.end(), [](const std::pair<uint64_t, float>& a, const std::pair<uint64_t, float>& b) { return a.first < b.first; });
+		stream.breakpoints_ = aBreakpoints;
+		return stream;
+	}
+	static Automation_Stream dense(uint64_t aStart, const float* aValues, uint32_t aNumValues)
+	{
+		Automation_Stream stream;
+		stream.start_ = aStart;
+		stream.values_.assign(aValues, aValues + aNumValues);
+		return stream;
+	}
+
+	bool isEmpty() const
+	{
+		return breakpoints_.empty() && values_.empty();
+	}
+	float valueAt(uint64_t aSample) const
+	{
+		if (!values_.empty())
+			return values_[aSample < start_ ? 0 : std::min<uint64_t>(aSample - start_, values_.size() - 1)];
+		if (breakpoints_.empty())
+			return 0.0f;
+
+		std::vector<std::pair<uint64_t, float>>::const_iterator after = std::upper_bound(breakpoints_.begin(), breakpoints_.end(), aSample,
+			[](uint64_t aSample, const std::pair<uint64_t, float>& aPoint) { return aSample < aPoint.first; });
+		if (after == breakpoints_.begin())
+			return after->second;
+		if (after == breakpoints_.end())
+			return breakpoints_.back().second;
+
+		const std::pair<uint64_t, float>& before = *(after - 1);
+		double t = (double)(aSample - before.first) / (double)(after->first - before.first);
+		return (float)(before.second + (after->second - before.second) * t);
+	}
+};
+
+#endif
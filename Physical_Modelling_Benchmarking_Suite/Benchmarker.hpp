@@ -1,112 +1,305 @@
 #ifndef BENCHMARKING_HPP
 #define BENCHMARKING_HPP
 
+#include <stdint.h>
 #include <iostream>
 #include <chrono>
+#include <cmath>
 #include <map>
 #include <vector>
 #include <string>
 
 #include "CSV_Logger.hpp"
+#include "Latency_Histogram.hpp"
 
 class Benchmarker
 {
+public:
+	//Index into the timer arrays, from registerTimer(). Measured loops should time through handles, as the string overloads look the name up on every call//
+	typedef uint32_t Timer_Handle;
 private:
-	std::map<std::string, std::chrono::time_point<std::chrono::steady_clock>> startTimers;
-	std::map<std::string, std::chrono::time_point<std::chrono::steady_clock>> endTimers;
-	std::map<std::string, std::chrono::time_point<std::chrono::steady_clock>> lastTimers;
-	std::map<std::string, std::chrono::duration<double>> totalTimers;
-	std::map<std::string, double> maxDurations;
-	std::map<std::string, double> minDurations;
-	std::map<std::string, double> maxDifference;
-	std::map<std::string, double> averageDifference;
-	std::map<std::string, double> lastElapsedTime;
-
-	std::map<std::string, uint32_t> cntTimersAverage;
+	typedef std::chrono::steady_clock Clock;
+
+	//Timer state, stored as one array per field and indexed by Timer_Handle, so start/pause touch no maps and never allocate//
+	std::map<std::string, Timer_Handle> handles_;
+	std::vector<std::string> names_;
+	std::vector<Clock::time_point> startTimers_;
+	std::vector<Clock::duration> totalTimers_;
+	std::vector<double> maxDurations_;
+	std::vector<double> minDurations_;
+	std::vector<double> maxDifference_;
+	std::vector<double> averageDifference_;
+	std::vector<double> lastElapsedTime_;
+	std::vector<uint32_t> cntTimersAverage_;
+
+	//Real-time mode - Timers given a deadline count the pauses that overran it, and the smallest margin left under it. A deadline of 0 is off//
+	std::vector<double> deadlines_;
+	std::vector<uint32_t> deadlineMisses_;
+	std::vector<double> worstSlack_;
+
+	//Every pauseTimer() interval, so elapsedTimer() can report tail latency rather than just the mean//
+	std::vector<Latency_Histogram> histograms_;
+	std::string path_;
+
+	//Fields past the timing columns are filled per timer from recordMetric()//
+	static const size_t numTimingFields_ = 7;
+	std::vector<std::string> metricFields_;
+	std::map<std::string, std::map<std::string, double>> metrics_;
 
 	CSV_Logger logger_;
+
+	//Percentile columns appended to every log, in ms//
+	static const std::vector<std::pair<std::string, double>>& percentileFields()
+	{
+		static const std::vector<std::pair<std::string, double>> fields = { { "P50", 50.0 }, { "P90", 90.0 }, { "P99", 99.0 }, { "P99_9", 99.9 } };
+		return fields;
+	}
+	static std::vector<std::string> withPercentileFields(std::vector<std::string> aFields)
+	{
+		for (uint32_t i = 0; i != percentileFields().size(); ++i)
+			aFields.push_back(percentileFields()[i].first);
+		return aFields;
+	}
+	static bool& isDumpingHistograms()
+	{
+		static bool isDumping = false;
+		return isDumping;
+	}
+	static double toMilliseconds(Clock::duration aDuration)
+	{
+		return std::chrono::duration<double, std::milli>(aDuration).count();
+	}
 public:
-	Benchmarker(const std::string aPath, const std::vector<std::string> aFields) : logger_(aPath, aFields)
+	Benchmarker(const std::string aPath, const std::vector<std::string> aFields) : path_(aPath), logger_(aPath, withPercentileFields(aFields))
+	{
+		if (aFields.size() > numTimingFields_)
+			metricFields_.assign(aFields.begin() + numTimingFields_, aFields.end());
+	}
+	//Allocates aTimer's storage, histogram included, and returns its handle. Registering an existing name returns the same handle//
+	Timer_Handle registerTimer(const std::string& aTimer)
 	{
+		auto it = handles_.find(aTimer);
+		if (it != handles_.end())
+			return it->second;
+
+		Timer_Handle handle = names_.size();
+		handles_[aTimer] = handle;
+		names_.push_back(aTimer);
+		startTimers_.push_back(Clock::time_point());
+		totalTimers_.push_back(Clock::duration::zero());
+		maxDurations_.push_back(0.0);
+		minDurations_.push_back(0.0);
+		maxDifference_.push_back(0.0);
+		averageDifference_.push_back(0.0);
+		lastElapsedTime_.push_back(0.0);
+		cntTimersAverage_.push_back(0);
+		deadlines_.push_back(0.0);
+		deadlineMisses_.push_back(0);
+		worstSlack_.push_back(0.0);
+		histograms_.push_back(Latency_Histogram());
+		return handle;
+	}
+	//When set, elapsedTimer() also writes each timer's raw histogram next to the log, as <log>_<timer>_histogram.csv//
+	static void setHistogramDump(bool aIsDumping)
+	{
+		isDumpingHistograms() = aIsDumping;
+	}
+	//Stores a value for one of the extra fields, written alongside aTimer's row by elapsedTimer()//
+	void recordMetric(const std::string aTimer, const std::string aMetric, double aValue)
+	{
+		metrics_[aTimer][aMetric] = aValue;
+	}
+	//Puts aTimer in real-time mode - Each pauseTimer() interval is checked against aDeadline ms, usually bufferLength / sampleRate//
+	//Results go to the "Deadline_Misses", "Miss_Fraction" and "Worst_Slack" fields when the logger has them//
+	void setDeadline(const std::string aTimer, double aDeadline)
+	{
+		deadlines_[registerTimer(aTimer)] = aDeadline;
+	}
+	uint32_t getDeadlineMisses(const std::string aTimer)
+	{
+		return deadlineMisses_[registerTimer(aTimer)];
+	}
+	//Fraction of intervals since startTimer() first ran that overran the deadline//
+	double getMissFraction(const std::string aTimer)
+	{
+		Timer_Handle timer = registerTimer(aTimer);
+		return cntTimersAverage_[timer] != 0 ? (double)deadlineMisses_[timer] / cntTimersAverage_[timer] : 0.0;
+	}
+	//Smallest deadline minus elapsed time in ms, negative once a deadline was missed//
+	double getWorstSlack(const std::string aTimer)
+	{
+		return worstSlack_[registerTimer(aTimer)];
+	}
+	//Time paused into aTimer since it was last logged, in ms - For comparing timers before elapsedTimer() resets them//
+	double getTotalTime(const std::string aTimer)
+	{
+		return toMilliseconds(totalTimers_[registerTimer(aTimer)]);
 	}
-	void startTimer(const std::string aTimer)
+
+	void startTimer(Timer_Handle aTimer)
 	{
-		if (cntTimersAverage[aTimer] == 0)
+		if (cntTimersAverage_[aTimer] == 0)
 		{
-			maxDifference[aTimer] = 0.0;
-			maxDurations[aTimer] = 0.0;
-			minDurations[aTimer] = 9999999.0;
+			maxDifference_[aTimer] = 0.0;
+			maxDurations_[aTimer] = 0.0;
+			minDurations_[aTimer] = 9999999.0;
+			deadlineMisses_[aTimer] = 0;
+			worstSlack_[aTimer] = deadlines_[aTimer];
+			histograms_[aTimer].reset();
 		}
 
 		//Start timer and increment number of timers//
-		++cntTimersAverage[aTimer];
-		startTimers[aTimer] = std::chrono::steady_clock::now();
+		++cntTimersAverage_[aTimer];
+		startTimers_[aTimer] = Clock::now();
 	}
-	void waitTimer(const std::string aTimer)
+	void waitTimer(Timer_Handle aTimer)
 	{
 		//Calculate total time//
-		endTimers[aTimer] = std::chrono::steady_clock::now();
-		totalTimers[aTimer] += endTimers[aTimer] - startTimers[aTimer];
+		totalTimers_[aTimer] += Clock::now() - startTimers_[aTimer];
 	}
-	void resumeTimer(const std::string aTimer)
+	void resumeTimer(Timer_Handle aTimer)
 	{
-		startTimers[aTimer] = std::chrono::steady_clock::now();
+		startTimers_[aTimer] = Clock::now();
 	}
-	void pauseTimer(const std::string aTimer)
+	void pauseTimer(Timer_Handle aTimer)
 	{
 		//Calculate total time//
-		endTimers[aTimer] = std::chrono::steady_clock::now();
-		totalTimers[aTimer] += endTimers[aTimer] - startTimers[aTimer];
+		Clock::duration interval = Clock::now() - startTimers_[aTimer];
+		totalTimers_[aTimer] += interval;
 
 		//Calculate differences//
-		double elapsedTime = std::chrono::duration <double, std::milli>((endTimers[aTimer] - startTimers[aTimer])).count();
-		double difference = abs(elapsedTime - lastElapsedTime[aTimer]);
-		averageDifference[aTimer] += difference;
-		lastElapsedTime[aTimer] = elapsedTime;
+		double elapsedTime = toMilliseconds(interval);
+		double difference = std::abs(elapsedTime - lastElapsedTime_[aTimer]);
+		averageDifference_[aTimer] += difference;
+		lastElapsedTime_[aTimer] = elapsedTime;
 
 		//Set max and mins//
-		maxDifference[aTimer] = difference > maxDifference[aTimer] ? difference : maxDifference[aTimer];
-		maxDurations[aTimer] = elapsedTime > maxDurations[aTimer] ? elapsedTime : maxDurations[aTimer];
-		minDurations[aTimer] = elapsedTime < minDurations[aTimer] ? elapsedTime : minDurations[aTimer];
+		maxDifference_[aTimer] = difference > maxDifference_[aTimer] ? difference : maxDifference_[aTimer];
+		maxDurations_[aTimer] = elapsedTime > maxDurations_[aTimer] ? elapsedTime : maxDurations_[aTimer];
+		minDurations_[aTimer] = elapsedTime < minDurations_[aTimer] ? elapsedTime : minDurations_[aTimer];
+		histograms_[aTimer].record(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count());
+
+		//Compare against the audio deadline//
+		if (deadlines_[aTimer] != 0.0)
+		{
+			double slack = deadlines_[aTimer] - elapsedTime;
+			deadlineMisses_[aTimer] += slack < 0.0 ? 1 : 0;
+			worstSlack_[aTimer] = slack < worstSlack_[aTimer] ? slack : worstSlack_[aTimer];
+		}
+	}
+	void endTimer(Timer_Handle aTimer)
+	{
+		totalTimers_[aTimer] += Clock::now() - startTimers_[aTimer];
+	}
+
+	void startTimer(const std::string& aTimer)
+	{
+		startTimer(registerTimer(aTimer));
+	}
+	void waitTimer(const std::string& aTimer)
+	{
+		waitTimer(registerTimer(aTimer));
+	}
+	void resumeTimer(const std::string& aTimer)
+	{
+		resumeTimer(registerTimer(aTimer));
+	}
+	void pauseTimer(const std::string& aTimer)
+	{
+		pauseTimer(registerTimer(aTimer));
+	}
+	void endTimer(const std::string& aTimer)
+	{
+		endTimer(registerTimer(aTimer));
 	}
-	void endTimer(const std::string aTimer)
+
+	//Calibration mode - Times aNumIterations back to back start/pause pairs on a scratch timer and reports the instrument's own cost.//
+	//Returns the mean cost of one pair in ns. The median interval a pause records is the floor under every per buffer timing//
+	double calibrate(uint32_t aNumIterations = 100000)
 	{
-		endTimers[aTimer] = std::chrono::steady_clock::now();
-		totalTimers[aTimer] += endTimers[aTimer] - startTimers[aTimer];
+		Timer_Handle timer = registerTimer("Timer_Calibration");
+		cntTimersAverage_[timer] = 0;
+
+		Clock::time_point begin = Clock::now();
+		for (uint32_t i = 0; i != aNumIterations; ++i)
+		{
+			startTimer(timer);
+			pauseTimer(timer);
+		}
+		double overhead = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / aNumIterations;
+
+		std::cout << "Benchmarker: Timer calibration over " << aNumIterations << " iterations" << std::endl;
+		std::cout << "Start/pause pair cost: " << overhead << "ns" << std::endl;
+		std::cout << "Empty interval P50: " << histograms_[timer].percentile(50.0) << "ns, P99: " << histograms_[timer].percentile(99.0) << "ns" << std::endl << std::endl;
+
+		cntTimersAverage_[timer] = 0;
+		totalTimers_[timer] = Clock::duration::zero();
+		return overhead;
 	}
+
 	void elapsedTimer(const std::string aTimer)
 	{
+		Timer_Handle timer = registerTimer(aTimer);
+
 		std::vector<std::string> record;
 		record.push_back(aTimer);
-		record.push_back(std::to_string(std::chrono::duration <double, std::milli>(totalTimers[aTimer]).count()));
+		record.push_back(std::to_string(toMilliseconds(totalTimers_[timer])));
 
 		//auto diff = end - start;
 		std::cout << "Benchmarker: " << aTimer << std::endl;
-		std::cout << "Total time to complete: " << std::chrono::duration<double>(totalTimers[aTimer]).count() << "s" << std::endl;
-		std::cout << "Total time to complete: " << std::chrono::duration <double, std::milli>(totalTimers[aTimer]).count() << "ms" << std::endl;
-		std::cout << "Total time to complete: " << std::chrono::duration <double, std::nano>(totalTimers[aTimer]).count() << "ns" << std::endl;
+		std::cout << "Total time to complete: " << std::chrono::duration<double>(totalTimers_[timer]).count() << "s" << std::endl;
+		std::cout << "Total time to complete: " << toMilliseconds(totalTimers_[timer]) << "ms" << std::endl;
+		std::cout << "Total time to complete: " << std::chrono::duration <double, std::nano>(totalTimers_[timer]).count() << "ns" << std::endl;
 
 		//Calculate average time per buffer & average difference//
-		if (cntTimersAverage[aTimer] > 1)
+		if (cntTimersAverage_[timer] > 1)
 		{
-			double avgElapsed = std::chrono::duration <double, std::milli>(totalTimers[aTimer]).count() / cntTimersAverage[aTimer];
+			double avgElapsed = toMilliseconds(totalTimers_[timer]) / cntTimersAverage_[timer];
 			std::cout << "Average time to complete each buffer: " << avgElapsed << "ms" << std::endl << std::endl;
 			record.push_back(std::to_string(avgElapsed));
-			averageDifference[aTimer] = averageDifference[aTimer] / cntTimersAverage[aTimer];
+			averageDifference_[timer] = averageDifference_[timer] / cntTimersAverage_[timer];
 		}
 		else
-			record.push_back(std::to_string(std::chrono::duration <double, std::milli>(totalTimers[aTimer]).count()));
+			record.push_back(std::to_string(toMilliseconds(totalTimers_[timer])));
 
-		record.push_back(std::to_string(maxDurations[aTimer]));
-		record.push_back(std::to_string(minDurations[aTimer]));
-		record.push_back(std::to_string(maxDifference[aTimer]));
-		record.push_back(std::to_string(averageDifference[aTimer]));
+		record.push_back(std::to_string(maxDurations_[timer]));
+		record.push_back(std::to_string(minDurations_[timer]));
+		record.push_back(std::to_string(maxDifference_[timer]));
+		record.push_back(std::to_string(averageDifference_[timer]));
+		if (deadlines_[timer] != 0.0)
+		{
+			recordMetric(aTimer, "Deadline_Misses", getDeadlineMisses(aTimer));
+			recordMetric(aTimer, "Miss_Fraction", getMissFraction(aTimer));
+			recordMetric(aTimer, "Worst_Slack", getWorstSlack(aTimer));
+		}
+		for (uint32_t i = 0; i != metricFields_.size(); ++i)
+		{
+			double value = metrics_[aTimer][metricFields_[i]];
+			std::cout << metricFields_[i] << ": " << value << std::endl;
+			record.push_back(std::to_string(value));
+		}
+		const Latency_Histogram& histogram = histograms_[timer];
+		for (uint32_t i = 0; i != percentileFields().size(); ++i)
+		{
+			double value = histogram.percentile(percentileFields()[i].second) / 1000000.0;
+			std::cout << percentileFields()[i].first << ": " << value << "ms" << std::endl;
+			record.push_back(std::to_string(value));
+		}
+		if (isDumpingHistograms())
+		{
+			std::string histogramPath = path_.substr(0, path_.rfind(".csv"));
+			histogramPath.append("_");
+			histogramPath.append(aTimer);
+			histogramPath.append("_histogram.csv");
+			histogram.dump(histogramPath);
+		}
 		logger_.addRecord(record);
+		metrics_.erase(aTimer);
 
 		//Reset timers//
-		cntTimersAverage[aTimer] = 0;
-		totalTimers[aTimer] = std::chrono::duration<double>(0).zero();
+		cntTimersAverage_[timer] = 0;
+		totalTimers_[timer] = Clock::duration::zero();
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,29 +1,48 @@
 #ifndef CARTISIAN_GRID_HPP
 #define CARTISIAN_GRID_HPP
 
+#include <algorithm>
+
+//Row major grid. Rows may be padded out to a pitch wider than the grid, so each row starts on an aligned address for coalesced access//
 template<typename T>
 class Cartisian_Grid {
 private:
 	const unsigned int width_;
 	const unsigned int height_;
-	const unsigned int size_;
+	const unsigned int pitch_;	//Elements from the start of one row to the next//
+	const unsigned int size_;	//Elements allocated, row padding included//
 
 	T* values_;				//Think of a better name for this?
 public:
-	Cartisian_Grid(unsigned int width, unsigned int height) :
+	Cartisian_Grid(unsigned int width, unsigned int height, unsigned int pitch = 0) :
 		width_(width),
 		height_(height),
-		size_(width_*height_),
+		pitch_(pitch > width ? pitch : width),
+		size_(pitch_*height_),
+		values_{ new T[size_]() } {
+	}
+	//Copies own their values - Sharing them is what made the destructor free them twice//
+	Cartisian_Grid(const Cartisian_Grid& other) :
+		width_(other.width_),
+		height_(other.height_),
+		pitch_(other.pitch_),
+		size_(other.size_),
 		values_{ new T[size_] } {
+		std::copy(other.values_, other.values_ + size_, values_);
 	}
+	Cartisian_Grid& operator=(const Cartisian_Grid&) = delete;
 
 	~Cartisian_Grid() {
-		values_ = nullptr;	//Why this needed to stop break?
 		delete[] values_;
 	}
 
+	//aWidth rounded up to a whole number of aAlignment elements//
+	static unsigned int alignedPitch(unsigned int aWidth, unsigned int aAlignment) {
+		return aAlignment > 1 ? (aWidth + aAlignment - 1) / aAlignment * aAlignment : aWidth;
+	}
+
 	int indexAt(unsigned int x, unsigned int y) const {
-		return (y*width_ + x);
+		return (y*pitch_ + x);
 	}
 
 	T* pointerAt(unsigned int x, unsigned int y) const {
@@ -38,6 +57,14 @@ public:
 	{
 		return values_;
 	}
+	unsigned int getPitch() const
+	{
+		return pitch_;
+	}
+	unsigned int getSize() const
+	{
+		return size_;
+	}
 };
 
 #endif
\ No newline at end of file
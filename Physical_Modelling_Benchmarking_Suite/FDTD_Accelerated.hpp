@@ -5,6 +5,10 @@
 #include <stdint.h>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <sstream>
 
 //#define CL_HPP_TARGET_OPENCL_VERSION 210
 //#define CL_HPP_MINIMUM_OPENCL_VERSION 200
@@ -19,12 +23,141 @@
 using nlohmann::json;
 
 #include "FDTD_Grid.hpp"
+#include "FDTD_CPU.hpp"
+#include "FDTD_Materials.hpp"
+#include "Folded_Kernel.hpp"
+#include "Automation_Stream.hpp"
 #include "Buffer.hpp"
+#include "Model_File.hpp"
+#include "Program_Binary_Cache.hpp"
+#include "Work_Group_Tuner.hpp"
+#include "FDTD_Reference.hpp"
 
 #include "Visualizer.hpp"
 
 enum DeviceType { INTEGRATED = 32902, DISCRETE = 4098, NVIDIA = 4318 };
-enum Implementation { OPENCL, CUDA, VULKAN, DIRECT3D };
+enum Implementation { OPENCL, CUDA, VULKAN, DIRECT3D, CPU, CPU_SIMD };
+enum StoragePrecision { STORAGE_HALF, STORAGE_SINGLE, STORAGE_DOUBLE };		//Bytes per pressure cell in the pitched grids - 2, 4 and 8//
+enum IdStorage { ID_INT, ID_UCHAR, ID_IMAGE };								//The pitched id grid as 32 bit ints, 8 bit ids or an 8 bit image//
+
+//Device side timings of fillBuffer from OpenCL profiling events, totalled since resetLaunchProfile(). All times in ms, summed over the sampled launches//
+//and buffers only, so scale by numLaunches / numProfiled or numBuffers / numProfiledBuffers for whole run totals//
+struct Launch_Profile
+{
+	uint32_t numBuffers = 0;
+	uint32_t numLaunches = 0;
+	uint32_t numProfiled = 0;			//Launches that carried an event, every profileInterval-th one//
+	uint32_t numProfiledBuffers = 0;	//Buffers whose transfers carried events, likewise//
+	double writeTime = 0.0;				//Excitation upload//
+	double readTime = 0.0;				//Output readback//
+	double kernelTime = 0.0;			//Kernel run time//
+	double queuedToSubmit = 0.0;		//Host side enqueue until the driver hands the launch to the device//
+	double submitToStart = 0.0;			//Waiting on the device, behind earlier commands//
+};
+
+//One material id's share of a split step - Its fdtdMaterialKernel and the run of the cell list it covers//
+struct Material_Launch
+{
+	int id = 0;
+	cl::Kernel kernel;
+	int firstCell = 0;
+	int numCells = 0;
+	cl::NDRange globalws;
+};
+
+//Everything createModel() builds on the device for one model, and what it found while building. FDTD_Accelerated steps the current model's copy and//
+//each Cached_Model keeps its own, so switching models swaps the whole struct. Programs are shared with other models using the same kernel source//
+struct Model_State
+{
+	//The model's own fdtdKernel, or Folded_Kernel's source in its place//
+	cl::Program program;
+	cl::Kernel kernel;
+	std::map<std::string, cl_uint> kernelArguments;	//kernel's argument indices by name, so coefficients bind by name rather than position//
+	cl::Buffer idGridBuffer;
+	cl::Buffer modelGrid;
+	cl::Buffer boundaryGridBuffer;
+	Material_Table materials;
+	cl::Buffer materialTypesBuffer;
+	cl::Buffer materialCoefficientsBuffer;
+
+	//Coefficient folding//
+	cl::Buffer foldedCoefficientsBuffer;	//The __constant Folded_Coefficients struct of an unbaked folded kernel//
+	bool isFoldedReady = false;
+	bool isBakedReady = false;
+
+	//Temporal blocking//
+	cl::Program blockedProgram;
+	cl::Kernel blockedKernel;
+	cl::NDRange blockedGlobalws;
+	cl::NDRange blockedLocalws;
+	cl::Buffer modelGridBack;
+	uint32_t maxStepsPerLaunch = 1;	//Largest block whose tile and halo fit in the device's local memory//
+	bool isBlockable = false;
+
+	//Persistent kernel//
+	cl::Program persistentProgram;
+	cl::Kernel persistentKernel;
+	cl::NDRange persistentws;
+	cl::Buffer persistentConnectionsBuffer;
+	bool isPersistentReady = false;
+
+	//Sparse dispatch//
+	cl::Program sparseProgram;
+	cl::Kernel sparseKernel;
+	cl::Kernel sparseConnectionsKernel;
+	cl::Buffer activeCellsBuffer;
+	cl::Buffer sparseConnectionsBuffer;
+	std::vector<int> activeModelCells;		//Cells that update or are written by a connection, in grid order//
+	int numSparseConnections = 0;
+	bool isSparseReady = false;
+
+	//Split dispatch//
+	std::vector<Material_Launch> materialLaunches;
+	cl::Kernel couplingKernel;
+	cl::Buffer materialCellsBuffer;
+	cl::Buffer couplingCellsBuffer;
+	cl::Buffer couplingConnectionsBuffer;
+	std::vector<int> materialCells;		//Every launch's cells back to back, in id order//
+	std::vector<int> splitClearCells;		//Connection destinations no launch updates, zeroed by the coupling pass before it adds to them//
+	bool isSplitReady = false;
+
+	//Pitched layout//
+	cl::Kernel pitchedKernel;
+	cl::Kernel pitchedConnectionsKernel;
+	cl::NDRange pitchedGlobalws;
+	cl::NDRange pitchedLocalws;
+	cl::Buffer pitchedIdGrid;
+	cl::Image2D pitchedIdImage;
+	cl::Buffer pitchedModelGrid;
+	cl::Buffer pitchedBoundaryGrid;
+	cl::Buffer pitchedConnectionsBuffer;
+	int pitch = 0;							//Cells from one row to the next in the pitched grids//
+	int numPitchedConnections = 0;
+	size_t pitchedGridByteSize = 0;		//All three levels, at the storage precision they were built for//
+	std::string pitchedOptions;			//Build options the pitched grids and kernels were made with//
+	bool isPitchedReady = false;
+};
+
+//Everything createModel() loads and builds for one model file. Cached by path, so a sweep reloading a model only resets its grids//
+struct Cached_Model
+{
+	std::filesystem::file_time_type writeTime;	//Newest of the JSON and its binary twin when loaded, so an edited model is reloaded//
+	uint64_t lastUse = 0;
+	std::string kernelSource;
+	std::map<int, std::string> materialKernels;	//Controllers' own fdtdMaterialKernel sources, by material id//
+	int width = 0;
+	int height = 0;
+	int* idGrid = nullptr;						//Into file when it maps int32 ids, otherwise into idGridStorage//
+	float* boundaryGrid = nullptr;
+	std::vector<int> idGridStorage;
+	std::vector<float> boundaryGridStorage;
+	std::unique_ptr<Model_File> file;
+	std::unique_ptr<Model> model;
+
+	//OpenCL state, valid once isBuilt//
+	bool isBuilt = false;
+	Model_State state;
+};
 
 struct Neighbour_Structure
 {
@@ -48,29 +181,144 @@ private:
 	cl::Context context_;
 	cl::Device device_;
 	cl::CommandQueue commandQueue_;
-	cl::Program kernelProgram_;
 	std::string kernelSourcePath_;
-	cl::Kernel kernel_;
 	cl::NDRange globalws_;
 	cl::NDRange localws_;
+	std::string workGroupKey_;		//Work_Group_Tuner's name for the current device, kernel and grid//
 
 	//CL Buffers//
-	cl::Buffer idGrid_;
-	cl::Buffer modelGrid_;
-	cl::Buffer boundaryGridBuffer_;
 	cl::Buffer outputBuffer_;
 	cl::Buffer excitationBuffer_;
 	cl::Buffer localBuffer_;
 
 	//Model//
+	Model_State state_;		//Everything built for the current model, swapped whole with its Cached_Model//
 	int listenerPosition_[2];
 	int excitationPosition_[2];
-	Model* model_;
+	Model* model_ = nullptr;
 	int modelWidth_;
 	int modelHeight_;
 	int gridElements_;
 	int gridByteSize_;
 
+	std::string commonKernelPath_ = "resources/kernels/fdtd_common.cl";	//Put in front of every kernel file by readKernelSource()//
+
+	//Temporal blocking - fdtdBlockedKernel advances several samples per launch for models without connections//
+	static const uint32_t blockTileSize_ = 16;
+	std::string blockedKernelPath_ = "resources/kernels/fdtd_temporal_blocking.cl";
+	bool isMaterialTableDirty_ = false;
+	uint32_t stepsPerLaunch_ = 1;
+
+	//Coefficient folding - kernel runs Folded_Kernel's source for the model's material table in place of the model's own fdtdKernel//
+	bool isFolded_ = false;
+	bool isBaked_ = false;
+	bool isFoldedDirty_ = false;		//Coefficients changed since an unbaked kernel last took them, uploaded by the next fillBuffer//
+
+	//Asynchronous pipeline - Two excitation/output pairs, so one buffer's upload and another's readback run on transferQueue_ while commandQueue_ computes//
+	static const uint32_t numAsyncSlots_ = 2;
+	cl::CommandQueue transferQueue_;
+	cl::Buffer asyncExcitationBuffers_[numAsyncSlots_];
+	cl::Buffer asyncOutputBuffers_[numAsyncSlots_];
+	std::vector<float> asyncInputs_[numAsyncSlots_];		//Staging copies, as non-blocking transfers need host memory that outlives the call//
+	std::vector<float> asyncOutputs_[numAsyncSlots_];
+	uint32_t asyncNumSteps_[numAsyncSlots_];
+	cl::Event uploadEvents_[numAsyncSlots_];
+	cl::Event computeStartEvents_[numAsyncSlots_];
+	cl::Event computeEndEvents_[numAsyncSlots_];
+	cl::Event readbackEvents_[numAsyncSlots_];
+	uint32_t numSubmitted_ = 0;
+	uint32_t numCollected_ = 0;
+	double uploadTime_ = 0.0;		//Device time in ms spent per stage by collected buffers//
+	double computeTime_ = 0.0;
+	double readbackTime_ = 0.0;
+
+	//Sample accurate automation - Streams run against sampleClock_, the samples computed since createModel(). A folded kernel is rebuilt to read a//
+	//table of folded coefficients per sample, one write per buffer into its slot's table. Other dispatches are refused by automateCoefficient()//
+	std::map<std::string, Automation_Stream> automation_;
+	uint64_t sampleClock_ = 0;
+	bool isAutomatedReady_ = false;
+	std::vector<float> automationTables_[numAsyncSlots_];		//Staging copies, one per slot as for the excitation//
+	cl::Buffer automationBuffers_[numAsyncSlots_];
+
+	//Kernel profiling - Every profileInterval_-th launch, and every profileInterval_-th buffer's transfers, get an event, 0 disables. fillBuffer() only//
+	//keeps them, getLaunchProfile() reads them into launchProfile_, so no profiling query lands inside a timed buffer//
+	uint32_t profileInterval_ = 0;
+	uint32_t numLaunches_ = 0;
+	std::vector<cl::Event> launchEvents_;
+	cl::Event writeEvent_;
+	cl::Event readEvent_;
+	std::vector<cl::Event> profiledLaunches_;
+	std::vector<cl::Event> profiledWrites_;
+	std::vector<cl::Event> profiledReads_;
+	Launch_Profile launchProfile_;
+
+	//Persistent kernel - fdtdPersistentKernel runs a whole buffer in one single work-group launch//
+	std::string persistentKernelPath_ = "resources/kernels/fdtd_persistent.cl";
+	bool isPersistent_ = false;
+
+	//Sparse dispatch - fdtdSparseKernel runs one work-item per active cell, listed at createModel(), rather than one per grid cell//
+	static const uint32_t sparseGroupSize_ = 64;
+	std::string sparseKernelPath_ = "resources/kernels/fdtd_sparse.cl";
+	cl::NDRange sparseGlobalws_;
+	cl::NDRange sparseLocalws_;
+	std::vector<int> activeCells_;			//As dispatched - Bucketed when asked, plus the excitation cell//
+	bool isSparse_ = false;
+	bool isSparseBucketed_ = false;
+
+	//Split dispatch - Each material id runs its own fdtdMaterialKernel over its own cells, then fdtdCouplingKernel adds the excitation, listener and connections//
+	std::string materialKernelPath_ = "resources/kernels/fdtd_material.cl";
+	bool isSplit_ = false;
+
+	//Pitched layout - fdtdPitchedKernel runs on its own copy of the grids, rows padded out to the device's base address alignment, over a global range//
+	//rounded up to whole work-groups. Its levels don't follow modelGrid, so the choice holds from one createModel() to the next//
+	static const uint32_t pitchedRowsPerGroup_ = 8;
+	std::string pitchedKernelPath_ = "resources/kernels/fdtd_pitched.cl";
+	StoragePrecision storagePrecision_ = STORAGE_SINGLE;
+	IdStorage idStorage_ = ID_INT;
+	bool isDoubleCompute_ = false;
+	bool isNeighbourMasked_ = false;
+	bool isPitched_ = false;
+
+	//Multi-tap I/O - fdtdTapKernel reads every output tap and excites every input tap after each step. Tap samples are interleaved, [sample * numTaps + tap]//
+	std::string tapKernelPath_ = "resources/kernels/fdtd_taps.cl";
+	cl::Program tapProgram_;
+	cl::Kernel tapKernel_;
+	cl::Buffer tapsBuffer_;
+	cl::Buffer tapInputBuffer_;
+	cl::Buffer tapOutputBuffer_;
+	std::vector<uint32_t> inputTapPositions_;	//(x, y) pairs, kept so taps follow the model through createModel()//
+	std::vector<uint32_t> outputTapPositions_;
+	std::vector<int> inputTaps_;
+	std::vector<int> outputTaps_;
+	std::vector<float> tapInputs_;				//Staged by setInputs(), consumed by the next fillBuffer()//
+	std::vector<float> tapOutputs_;				//The last fillBuffer()'s tap samples//
+	uint32_t numTapOutputSamples_ = 0;
+	bool isTapKernelReady_ = false;
+	bool isTapping_ = false;					//Only while fillBuffer() enqueues its steps, so submitBuffer() leaves the taps alone//
+
+	//Batched voices - fdtdBatchedKernel advances numVoices_ copies of the model per launch, each with its own levels, positions and coefficients//
+	std::string batchedKernelPath_ = "resources/kernels/fdtd_batched.cl";
+	cl::Program batchedProgram_;
+	cl::Kernel batchedKernel_;
+	cl::Kernel batchedConnectionsKernel_;
+	cl::NDRange batchedGlobalws_;
+	cl::NDRange batchedLocalws_;
+	cl::Buffer voiceGrids_;
+	cl::Buffer voiceInputBuffer_;
+	cl::Buffer voiceOutputBuffer_;
+	cl::Buffer voiceInputPositionsBuffer_;
+	cl::Buffer voiceOutputPositionsBuffer_;
+	cl::Buffer voiceCoefficientsBuffer_;
+	cl::Buffer batchedConnectionsBuffer_;
+	std::vector<Material_Table> voiceMaterials_;
+	std::vector<int> voiceInputPositions_;
+	std::vector<int> voiceOutputPositions_;
+	uint32_t numVoices_ = 0;					//0 runs the single model//
+	int numBatchedConnections_ = 0;
+	int batchedRotationIndex_ = 1;				//Kept apart from bufferRotationIndex_, so the single model's levels stay in step//
+	bool isBatchedReady_ = false;
+	bool isVoiceTableDirty_ = false;
+
 	int numConnections_ = 4;
 	int* connections_ = new int[numConnections_];
 	cl::Buffer connectionsBuffer_;
@@ -83,11 +331,21 @@ private:
 
 	int bufferRotationIndex_ = 1;
 
+	//Native host backend used when implementation_ is CPU or CPU_SIMD//
+	FDTD_CPU* cpuEngine_ = nullptr;
+
 	Visualizer* vis;
 
-	float* renderGrid;
+	float* renderGrid = nullptr;
 	int* idGridInput_;
 	float* boundaryGridInput_;
+
+	//Model and program caches - Models are keyed by path, programs by source hash, build options and device//
+	std::map<std::string, Cached_Model> modelCache_;
+	std::map<std::string, cl::Program> programCache_;
+	uint32_t modelCacheCapacity_ = 4;			//Device memory is the limit - A 1024x1024 model holds ~32MB of buffers//
+	uint64_t numModelLoads_ = 0;
+	bool isSharedBuffersReady_ = false;
 	//Cartisian_Grid<int> idGridInput_;
 	//int* two_dimensional_grid_;
 
@@ -111,36 +369,27 @@ private:
 				auto d = device.getInfo<CL_DEVICE_VENDOR_ID>();
 				if (d == deviceType_)
 				{
+					device_ = device;
+
 					//Create command queue for first device - Profiling enabled//
 					commandQueue_ = cl::CommandQueue(context_, device, CL_QUEUE_PROFILING_ENABLE, &errorStatus_);	//Need to specify device 1[0] of platform 3[2] for dedicated graphics - Harri Laptop.
 					if (errorStatus_)
 						std::cout << "ERROR creating command queue for device. Status code: " << errorStatus_ << std::endl;
+					transferQueue_ = cl::CommandQueue(context_, device, CL_QUEUE_PROFILING_ENABLE, &errorStatus_);
+					if (errorStatus_)
+						std::cout << "ERROR creating transfer queue for device. Status code: " << errorStatus_ << std::endl;
 
 					std::cout << "\t\tDevice Name Chosen: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
 
-					// A way of automatically setting local work group sizes.
-					auto sizes = device.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
-					auto max = device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE >();
-					//localws_.get()[0] = sizes[0];
-					//localws_.get()[1] = sizes[1];
-
-
+					//Local work group sizes are chosen per model by tuneWorkGroup(), against the device's limits//
 					return;
 				}
 			}
 			std::cout << std::endl;
 		}
 	}
-	void initBuffersCL()
+	void initConnections()
 	{
-		//Create input and output buffer for grid points//
-		idGrid_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
-		modelGrid_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_ * 3);
-		boundaryGridBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_);
-		outputBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, output_.bufferSize_ * sizeof(float));
-		excitationBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, excitation_.bufferSize_ * sizeof(float));
-		connectionsBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, numConnections_ * sizeof(int));
-
 		//Connections
 
 		//64
@@ -172,25 +421,546 @@ private:
 		//connections_[1] = 36382;
 		//connections_[2] = 935454;
 		//connections_[3] = 247573;
+	}
+	//Excitation, output and connection buffers don't depend on the model, so every model shares one set//
+	void initSharedBuffersCL()
+	{
+		outputBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, output_.bufferSize_ * sizeof(float));
+		excitationBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, excitation_.bufferSize_ * sizeof(float));
+		connectionsBuffer_ = cl::Buffer(context_, CL_MEM_READ_WRITE, numConnections_ * sizeof(int));
+		for (uint32_t i = 0; i != numAsyncSlots_; ++i)
+		{
+			asyncExcitationBuffers_[i] = cl::Buffer(context_, CL_MEM_READ_ONLY, excitation_.bufferSize_);
+			asyncOutputBuffers_[i] = cl::Buffer(context_, CL_MEM_WRITE_ONLY, output_.bufferSize_);
+		}
+		commandQueue_.enqueueWriteBuffer(connectionsBuffer_, CL_TRUE, 0, numConnections_ * sizeof(int), connections_);
+		isSharedBuffersReady_ = true;
+	}
+	void initBuffersCL()
+	{
+		//Create input and output buffer for grid points//
+		//Ids and boundary weights are static from here on, so the device may cache them as read-only//
+		state_.idGridBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, gridByteSize_);
+		state_.modelGrid = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_ * 3);
+		state_.boundaryGridBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, gridByteSize_);
+		if (!isSharedBuffersReady_)
+			initSharedBuffersCL();
 
 		//Copy data to newly created device's memory//
-		float* temporaryGrid =  new float[gridElements_ * 3];
-		memset(temporaryGrid, 0, gridByteSize_ * 3);
-
-		commandQueue_.enqueueWriteBuffer(idGrid_, CL_TRUE, 0, gridByteSize_ , idGridInput_);
-		commandQueue_.enqueueWriteBuffer(modelGrid_, CL_TRUE, 0, gridByteSize_*3, temporaryGrid);
-		commandQueue_.enqueueWriteBuffer(boundaryGridBuffer_, CL_TRUE, 0, gridByteSize_, boundaryGridInput_);
-		commandQueue_.enqueueWriteBuffer(connectionsBuffer_, CL_TRUE, 0, numConnections_ * sizeof(int), connections_);
+		commandQueue_.enqueueWriteBuffer(state_.idGridBuffer, CL_TRUE, 0, gridByteSize_ , idGridInput_);
+		commandQueue_.enqueueFillBuffer(state_.modelGrid, 0.0f, 0, gridByteSize_ * 3);
+		commandQueue_.enqueueWriteBuffer(state_.boundaryGridBuffer, CL_TRUE, 0, gridByteSize_, boundaryGridInput_);
+	}
+	//Copies the model state built by createModel() into aModel, or back out of it, so a cached model can be switched to without a rebuild//
+	void storeModelState(Cached_Model& aModel) const
+	{
+		aModel.state = state_;
+		aModel.isBuilt = true;
+	}
+	void restoreModelState(const Cached_Model& aModel)
+	{
+		state_ = aModel.state;
+	}
+	//Zeroes every time level and puts back the parsed coefficients, leaving a restored model as createModel() first built it//
+	void resetModelGrids()
+	{
+		commandQueue_.enqueueFillBuffer(state_.modelGrid, 0.0f, 0, gridByteSize_ * 3);
+		if (state_.isBlockable)
+			commandQueue_.enqueueFillBuffer(state_.modelGridBack, 0.0f, 0, gridByteSize_ * 3);
+		if (state_.isPitchedReady)
+			commandQueue_.enqueueFillBuffer(state_.pitchedModelGrid, (cl_uchar)0, 0, state_.pitchedGridByteSize);
+
+		//stepBlock() may have left kernel on what is now the back grid//
+		state_.kernel.setArg(1, sizeof(cl_mem), &state_.modelGrid);
+		uploadMaterialTable();
+		isFoldedDirty_ = state_.isFoldedReady && !state_.isBakedReady;
 	}
 	void step()
 	{
-		commandQueue_.enqueueNDRangeKernel(kernel_, cl::NullRange/*globaloffset*/, globalws_, localws_, NULL);
+		commandQueue_.enqueueNDRangeKernel(state_.kernel, cl::NullRange/*globaloffset*/, globalws_, localws_, NULL, nextLaunchEvent());
 		//commandQueue_.finish();
+		if (isTapping_)
+			stepTaps();
+
+		output_.bufferIndex_++;
+		excitation_.bufferIndex_++;
+		bufferRotationIndex_ = (bufferRotationIndex_ + 1) % 3;
+	}
+	void stepBlock(int aNumSteps)
+	{
+		//Local memory holds two time levels, open weights and ids for the tile plus its halo//
+		uint32_t halo = state_.materials.stencilRadius() * aNumSteps;
+		uint32_t regionSize = (blockTileSize_ + 2 * halo) * (blockTileSize_ + 2 * halo);
+
+		state_.blockedKernel.setArg(1, sizeof(cl_mem), &state_.modelGrid);
+		state_.blockedKernel.setArg(2, sizeof(cl_mem), &state_.modelGridBack);
+		state_.blockedKernel.setArg(4, sizeof(int), &bufferRotationIndex_);
+		state_.blockedKernel.setArg(5, sizeof(int), &output_.bufferIndex_);
+		state_.blockedKernel.setArg(6, sizeof(int), &aNumSteps);
+		state_.blockedKernel.setArg(17, cl::Local(regionSize * sizeof(float)));
+		state_.blockedKernel.setArg(18, cl::Local(regionSize * sizeof(float)));
+		state_.blockedKernel.setArg(19, cl::Local(regionSize * sizeof(float)));
+		state_.blockedKernel.setArg(20, cl::Local(regionSize * sizeof(int)));
+		commandQueue_.enqueueNDRangeKernel(state_.blockedKernel, cl::NullRange, state_.blockedGlobalws, state_.blockedLocalws, NULL, nextLaunchEvent());
+
+		//Finished levels were written to the back grid, which now becomes the model grid//
+		std::swap(state_.modelGrid, state_.modelGridBack);
+		state_.kernel.setArg(1, sizeof(cl_mem), &state_.modelGrid);
+
+		output_.bufferIndex_ += aNumSteps;
+		excitation_.bufferIndex_ += aNumSteps;
+		bufferRotationIndex_ = (bufferRotationIndex_ + aNumSteps) % 3;
+	}
+	//Enqueues numSteps samples on commandQueue_ with the active dispatch strategy, reading excitation from aExcitation and writing samples to aOutput//
+	void enqueueSteps(cl::Buffer& aExcitation, cl::Buffer& aOutput, uint32_t numSteps)
+	{
+		if (isFoldedDirty_)
+			uploadFoldedCoefficients();
+		state_.kernel.setArg(5, sizeof(cl_mem), &aExcitation);
+		state_.kernel.setArg(6, sizeof(cl_mem), &aOutput);
+		if (state_.isBlockable)
+		{
+			state_.blockedKernel.setArg(7, sizeof(cl_mem), &aExcitation);
+			state_.blockedKernel.setArg(8, sizeof(cl_mem), &aOutput);
+		}
+		if (state_.isPersistentReady)
+		{
+			state_.persistentKernel.setArg(6, sizeof(cl_mem), &aExcitation);
+			state_.persistentKernel.setArg(7, sizeof(cl_mem), &aOutput);
+		}
+		if (state_.isSparseReady)
+		{
+			state_.sparseKernel.setArg(5, sizeof(cl_mem), &aExcitation);
+			state_.sparseKernel.setArg(6, sizeof(cl_mem), &aOutput);
+		}
+		if (state_.isSplitReady)
+		{
+			state_.couplingKernel.setArg(4, sizeof(cl_mem), &aExcitation);
+			state_.couplingKernel.setArg(5, sizeof(cl_mem), &aOutput);
+		}
+		if (state_.isPitchedReady)
+		{
+			state_.pitchedKernel.setArg(5, sizeof(cl_mem), &aExcitation);
+			state_.pitchedKernel.setArg(6, sizeof(cl_mem), &aOutput);
+		}
+
+		//Taps are applied between steps on modelGrid, so the multi-step launches and the pitched grids give way to per sample ones while tapping//
+		if (isTapping_)
+			tapKernel_.setArg(0, sizeof(cl_mem), &state_.modelGrid);
+		uint32_t blockSteps = stepsPerLaunch_ < state_.maxStepsPerLaunch ? stepsPerLaunch_ : state_.maxStepsPerLaunch;
+		if (isPersistent_ && state_.isPersistentReady && !isTapping_)
+		{
+			if (isMaterialTableDirty_)
+				uploadMaterialTable();
+
+			stepPersistent(numSteps);
+		}
+		else if (isSparse_ && state_.isSparseReady)
+		{
+			if (isMaterialTableDirty_)
+				uploadMaterialTable();
+
+			state_.sparseKernel.setArg(1, sizeof(cl_mem), &state_.modelGrid);
+			if (state_.numSparseConnections != 0)
+				state_.sparseConnectionsKernel.setArg(0, sizeof(cl_mem), &state_.modelGrid);
+			for (uint32_t i = 0; i != numSteps; ++i)
+				stepSparse();
+		}
+		else if (isSplit_ && state_.isSplitReady)
+		{
+			if (isMaterialTableDirty_)
+				uploadMaterialTable();
+
+			for (uint32_t i = 0; i != state_.materialLaunches.size(); ++i)
+				state_.materialLaunches[i].kernel.setArg(0, sizeof(cl_mem), &state_.modelGrid);
+			state_.couplingKernel.setArg(0, sizeof(cl_mem), &state_.modelGrid);
+			for (uint32_t i = 0; i != numSteps; ++i)
+				stepSplit();
+		}
+		else if (isPitched_ && state_.isPitchedReady && !isTapping_)
+		{
+			if (isMaterialTableDirty_)
+				uploadMaterialTable();
+
+			for (uint32_t i = 0; i != numSteps; ++i)
+				stepPitched();
+		}
+		else if (state_.isBlockable && blockSteps > 1 && numSteps > 1 && !isTapping_)
+		{
+			if (isMaterialTableDirty_)
+				uploadMaterialTable();
+
+			//Advance in blocks of blockSteps samples, with a shorter final block if numSteps doesn't divide evenly//
+			for (uint32_t i = 0; i < numSteps; i += blockSteps)
+				stepBlock(numSteps - i < blockSteps ? numSteps - i : blockSteps);
+		}
+		else
+		{
+			//Calculate buffer size of synthesizer output samples//
+			for (unsigned int i = 0; i != numSteps; ++i)
+			{
+				//Increments kernel indices//
+				state_.kernel.setArg(4, sizeof(int), &output_.bufferIndex_);
+				state_.kernel.setArg(3, sizeof(int), &bufferRotationIndex_);
+
+				step();
+			}
+		}
+
+		output_.resetIndex();
+		excitation_.resetIndex();
+	}
+	//Milliseconds between the ends of two profiled commands, and the run time of one//
+	static double eventDuration(const cl::Event& aStart, const cl::Event& aEnd)
+	{
+		return (aEnd.getProfilingInfo<CL_PROFILING_COMMAND_END>() - aStart.getProfilingInfo<CL_PROFILING_COMMAND_END>()) / 1000000.0;
+	}
+	static double commandDuration(const cl::Event& aEvent)
+	{
+		return (aEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>() - aEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>()) / 1000000.0;
+	}
+	//Event for the launch about to be enqueued, or NULL when this one isn't sampled//
+	cl::Event* nextLaunchEvent()
+	{
+		if (profileInterval_ == 0 || numLaunches_++ % profileInterval_ != 0)
+			return NULL;
+
+		launchEvents_.push_back(cl::Event());
+		return &launchEvents_.back();
+	}
+	//True when the next buffer's transfers are sampled//
+	bool isBufferProfiled() const
+	{
+		return profileInterval_ != 0 && launchProfile_.numBuffers % profileInterval_ == 0;
+	}
+	//Counts one finished fillBuffer and keeps its events for getLaunchProfile(), without querying them//
+	void accumulateLaunchProfile(uint32_t aNumLaunches, bool aIsBufferProfiled)
+	{
+		profiledLaunches_.insert(profiledLaunches_.end(), launchEvents_.begin(), launchEvents_.end());
+		if (aIsBufferProfiled)
+		{
+			profiledWrites_.push_back(writeEvent_);
+			profiledReads_.push_back(readEvent_);
+		}
+		launchProfile_.numLaunches += aNumLaunches;
+		++launchProfile_.numBuffers;
+		launchEvents_.clear();
+	}
+	void stepPersistent(int aNumSteps)
+	{
+		state_.persistentKernel.setArg(1, sizeof(cl_mem), &state_.modelGrid);
+		state_.persistentKernel.setArg(3, sizeof(int), &bufferRotationIndex_);
+		state_.persistentKernel.setArg(4, sizeof(int), &output_.bufferIndex_);
+		state_.persistentKernel.setArg(5, sizeof(int), &aNumSteps);
+		commandQueue_.enqueueNDRangeKernel(state_.persistentKernel, cl::NullRange, state_.persistentws, state_.persistentws, NULL, nextLaunchEvent());
+
+		output_.bufferIndex_ += aNumSteps;
+		excitation_.bufferIndex_ += aNumSteps;
+		bufferRotationIndex_ = (bufferRotationIndex_ + aNumSteps) % 3;
+	}
+	void stepSparse()
+	{
+		state_.sparseKernel.setArg(3, sizeof(int), &bufferRotationIndex_);
+		state_.sparseKernel.setArg(4, sizeof(int), &output_.bufferIndex_);
+		commandQueue_.enqueueNDRangeKernel(state_.sparseKernel, cl::NullRange, sparseGlobalws_, sparseLocalws_, NULL, nextLaunchEvent());
+		if (state_.numSparseConnections != 0)
+		{
+			state_.sparseConnectionsKernel.setArg(1, sizeof(int), &bufferRotationIndex_);
+			commandQueue_.enqueueNDRangeKernel(state_.sparseConnectionsKernel, cl::NullRange, cl::NDRange(1), cl::NDRange(1), NULL, nextLaunchEvent());
+		}
+		if (isTapping_)
+			stepTaps();
+
+		output_.bufferIndex_++;
+		excitation_.bufferIndex_++;
+		bufferRotationIndex_ = (bufferRotationIndex_ + 1) % 3;
+	}
+	//Every material's launch, then the coupling pass. The in-order queue keeps the pass behind all of them//
+	void stepSplit()
+	{
+		for (uint32_t i = 0; i != state_.materialLaunches.size(); ++i)
+		{
+			state_.materialLaunches[i].kernel.setArg(2, sizeof(int), &bufferRotationIndex_);
+			commandQueue_.enqueueNDRangeKernel(state_.materialLaunches[i].kernel, cl::NullRange, state_.materialLaunches[i].globalws, cl::NDRange(sparseGroupSize_), NULL, nextLaunchEvent());
+		}
+		state_.couplingKernel.setArg(1, sizeof(int), &bufferRotationIndex_);
+		state_.couplingKernel.setArg(2, sizeof(int), &output_.bufferIndex_);
+		commandQueue_.enqueueNDRangeKernel(state_.couplingKernel, cl::NullRange, cl::NDRange(1), cl::NDRange(1), NULL, nextLaunchEvent());
+		if (isTapping_)
+			stepTaps();
 
 		output_.bufferIndex_++;
 		excitation_.bufferIndex_++;
 		bufferRotationIndex_ = (bufferRotationIndex_ + 1) % 3;
 	}
+	void stepPitched()
+	{
+		state_.pitchedKernel.setArg(3, sizeof(int), &bufferRotationIndex_);
+		state_.pitchedKernel.setArg(4, sizeof(int), &output_.bufferIndex_);
+		commandQueue_.enqueueNDRangeKernel(state_.pitchedKernel, cl::NullRange, state_.pitchedGlobalws, state_.pitchedLocalws, NULL, nextLaunchEvent());
+		if (state_.numPitchedConnections != 0)
+		{
+			state_.pitchedConnectionsKernel.setArg(1, sizeof(int), &bufferRotationIndex_);
+			commandQueue_.enqueueNDRangeKernel(state_.pitchedConnectionsKernel, cl::NullRange, cl::NDRange(1), cl::NDRange(1), NULL, nextLaunchEvent());
+		}
+
+		output_.bufferIndex_++;
+		excitation_.bufferIndex_++;
+		bufferRotationIndex_ = (bufferRotationIndex_ + 1) % 3;
+	}
+	//Tap (x, y) pairs as cell indices of the current model, -1 for any off the grid//
+	std::vector<int> tapIndices(const std::vector<uint32_t>& aPositions) const
+	{
+		std::vector<int> taps;
+		for (uint32_t i = 0; i + 1 < aPositions.size(); i += 2)
+			taps.push_back(aPositions[i] < (uint32_t)modelWidth_ && aPositions[i + 1] < (uint32_t)modelHeight_ ? aPositions[i + 1] * modelWidth_ + aPositions[i] : -1);
+		return taps;
+	}
+	//Places the taps on the current model and uploads them, with the input taps no update writes to be cleared each step. Called by createModel() and the setters//
+	void uploadTaps()
+	{
+		if (model_ == nullptr)
+			return;
+
+		inputTaps_ = tapIndices(inputTapPositions_);
+		outputTaps_ = tapIndices(outputTapPositions_);
+		if (isHostImplementation())
+		{
+			cpuEngine_->setTaps(inputTaps_, outputTaps_);
+			return;
+		}
+		if (inputTaps_.empty() && outputTaps_.empty())
+			return;
+
+		if (!isTapKernelReady_)
+			isTapKernelReady_ = createKernelFromFile(tapKernelPath_, "fdtdTapKernel", "", tapProgram_, tapKernel_);
+		if (!isTapKernelReady_)
+			return;
+
+		int radius = state_.materials.stencilRadius();
+		int numMaterials = state_.materials.types().size();
+		std::vector<int> taps = inputTaps_;
+		taps.insert(taps.end(), outputTaps_.begin(), outputTaps_.end());
+		for (uint32_t i = 0; i != inputTaps_.size(); ++i)
+		{
+			int tap = inputTaps_[i];
+			if (tap < 0 || tap == model_->getInputPosition() || std::find(taps.begin() + inputTaps_.size() + outputTaps_.size(), taps.end(), tap) != taps.end())
+				continue;
+			int x = tap % modelWidth_;
+			int y = tap / modelWidth_;
+			int id = idGridInput_[tap];
+			bool isUpdated = x >= radius && x < modelWidth_ - radius && y >= radius && y < modelHeight_ - radius && id > 0 && id < numMaterials && state_.materials.types()[id] != 0;
+			if (!isUpdated)
+				taps.push_back(tap);
+		}
+
+		int gridSize = gridElements_;
+		int numInputs = inputTaps_.size();
+		int numOutputs = outputTaps_.size();
+		int numClearCells = taps.size() - numInputs - numOutputs;
+		tapsBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, taps.size() * sizeof(int));
+		commandQueue_.enqueueWriteBuffer(tapsBuffer_, CL_TRUE, 0, taps.size() * sizeof(int), taps.data());
+		tapInputBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, (numInputs == 0 ? 1 : numInputs) * excitation_.numberSamples_ * sizeof(float));
+		tapOutputBuffer_ = cl::Buffer(context_, CL_MEM_WRITE_ONLY, (numOutputs == 0 ? 1 : numOutputs) * output_.numberSamples_ * sizeof(float));
+
+		tapKernel_.setArg(3, sizeof(int), &gridSize);
+		tapKernel_.setArg(4, sizeof(cl_mem), &tapsBuffer_);
+		tapKernel_.setArg(5, sizeof(int), &numInputs);
+		tapKernel_.setArg(6, sizeof(int), &numOutputs);
+		tapKernel_.setArg(7, sizeof(int), &numClearCells);
+		tapKernel_.setArg(8, sizeof(cl_mem), &tapInputBuffer_);
+		tapKernel_.setArg(9, sizeof(cl_mem), &tapOutputBuffer_);
+	}
+	//Runs behind the step's update, before the rotation moves on//
+	void stepTaps()
+	{
+		tapKernel_.setArg(1, sizeof(int), &bufferRotationIndex_);
+		tapKernel_.setArg(2, sizeof(int), &output_.bufferIndex_);
+		commandQueue_.enqueueNDRangeKernel(tapKernel_, cl::NullRange, cl::NDRange(1), cl::NDRange(1), NULL, nextLaunchEvent());
+	}
+	//An excitation on a cell no material updates has to be cleared by the coupling pass before it is added, as a connection destination is//
+	void uploadCouplingCells()
+	{
+		std::vector<int> clearCells = state_.splitClearCells;
+		int inputPosition = model_->getInputPosition();
+		if (inputPosition >= 0 && inputPosition < gridElements_ && std::find(state_.materialCells.begin(), state_.materialCells.end(), inputPosition) == state_.materialCells.end()
+			&& std::find(clearCells.begin(), clearCells.end(), inputPosition) == clearCells.end())
+			clearCells.push_back(inputPosition);
+
+		int numClearCells = clearCells.size();
+		if (numClearCells != 0)
+			commandQueue_.enqueueWriteBuffer(state_.couplingCellsBuffer, CL_TRUE, 0, clearCells.size() * sizeof(int), clearCells.data());
+		state_.couplingKernel.setArg(9, sizeof(int), &numClearCells);
+	}
+	//Orders the active cells for dispatch and uploads them. Called whenever the excitation cell or bucketing changes//
+	void uploadActiveCells()
+	{
+		activeCells_ = state_.activeModelCells;
+		if (isSparseBucketed_)
+		{
+			//Group by material, each group padded to whole work-groups so every group takes one update path//
+			std::stable_sort(activeCells_.begin(), activeCells_.end(), [this](int aLeft, int aRight) { return idGridInput_[aLeft] < idGridInput_[aRight]; });
+			std::vector<int> bucketed;
+			for (uint32_t i = 0; i != activeCells_.size(); ++i)
+			{
+				if (i != 0 && idGridInput_[activeCells_[i]] != idGridInput_[activeCells_[i - 1]])
+					bucketed.resize((bucketed.size() + sparseGroupSize_ - 1) / sparseGroupSize_ * sparseGroupSize_, -1);
+				bucketed.push_back(activeCells_[i]);
+			}
+			bucketed.resize((bucketed.size() + sparseGroupSize_ - 1) / sparseGroupSize_ * sparseGroupSize_, -1);
+			activeCells_.swap(bucketed);
+		}
+
+		//An excitation on an empty cell still has to be written, and cleared again, each step//
+		int inputPosition = model_->getInputPosition();
+		if (inputPosition >= 0 && inputPosition < gridElements_ && std::find(state_.activeModelCells.begin(), state_.activeModelCells.end(), inputPosition) == state_.activeModelCells.end())
+			activeCells_.push_back(inputPosition);
+
+		int numActiveCells = activeCells_.size();
+		if (numActiveCells != 0)
+			commandQueue_.enqueueWriteBuffer(state_.activeCellsBuffer, CL_TRUE, 0, activeCells_.size() * sizeof(int), activeCells_.data());
+		state_.sparseKernel.setArg(16, sizeof(int), &numActiveCells);
+
+		//At least one work-item, as the first also reads the listener//
+		uint32_t numGroups = (activeCells_.size() + sparseGroupSize_ - 1) / sparseGroupSize_;
+		sparseGlobalws_ = cl::NDRange((numGroups == 0 ? 1 : numGroups) * sparseGroupSize_);
+		sparseLocalws_ = cl::NDRange(sparseGroupSize_);
+	}
+	//Every voice's coefficient table back to back, [voice][id]//
+	void uploadVoiceTable()
+	{
+		std::vector<Material_Coefficients> coefficients;
+		for (uint32_t i = 0; i != voiceMaterials_.size(); ++i)
+			coefficients.insert(coefficients.end(), voiceMaterials_[i].coefficientTable().begin(), voiceMaterials_[i].coefficientTable().end());
+		commandQueue_.enqueueWriteBuffer(voiceCoefficientsBuffer_, CL_TRUE, 0, coefficients.size() * sizeof(Material_Coefficients), coefficients.data());
+		isVoiceTableDirty_ = false;
+	}
+	void uploadVoicePositions()
+	{
+		commandQueue_.enqueueWriteBuffer(voiceInputPositionsBuffer_, CL_TRUE, 0, numVoices_ * sizeof(int), voiceInputPositions_.data());
+		commandQueue_.enqueueWriteBuffer(voiceOutputPositionsBuffer_, CL_TRUE, 0, numVoices_ * sizeof(int), voiceOutputPositions_.data());
+	}
+	//One batched launch per sample advances every voice, followed by each voice's connections//
+	void stepBatched(uint32_t numSteps)
+	{
+		if (isVoiceTableDirty_)
+			uploadVoiceTable();
+
+		for (uint32_t i = 0; i != numSteps; ++i)
+		{
+			int idxSample = i;
+			batchedKernel_.setArg(3, sizeof(int), &batchedRotationIndex_);
+			batchedKernel_.setArg(4, sizeof(int), &idxSample);
+			commandQueue_.enqueueNDRangeKernel(batchedKernel_, cl::NullRange, batchedGlobalws_, batchedLocalws_, NULL, nextLaunchEvent());
+			if (numBatchedConnections_ != 0)
+			{
+				batchedConnectionsKernel_.setArg(1, sizeof(int), &batchedRotationIndex_);
+				commandQueue_.enqueueNDRangeKernel(batchedConnectionsKernel_, cl::NullRange, cl::NDRange(numVoices_), cl::NullRange, NULL, nextLaunchEvent());
+			}
+			batchedRotationIndex_ = (batchedRotationIndex_ + 1) % 3;
+		}
+	}
+	//Puts the folded coefficients into an unbaked kernel - One write of its coefficient struct//
+	void uploadFoldedCoefficients()
+	{
+		std::vector<float> values = Folded_Kernel::values(state_.materials);
+		if (!values.empty() && !isAutomatedReady_)
+			commandQueue_.enqueueWriteBuffer(state_.foldedCoefficientsBuffer, CL_TRUE, 0, values.size() * sizeof(float), values.data());
+		isFoldedDirty_ = false;
+	}
+	//Builds a baked kernel again with the current folded values, then sets every argument again. Only ever called from updateCoefficient(), so the//
+	//build lands on the coefficient change and never inside fillBuffer//
+	void bakeFoldedCoefficients()
+	{
+		createExplicitEquation(Folded_Kernel::source(state_.materials, true), Folded_Kernel::bakedOptions(state_.materials));
+		int inPos = model_->getInputPosition();
+		int outPos = model_->getOutputPosition();
+		state_.kernel.setArg(7, sizeof(int), &inPos);
+		state_.kernel.setArg(8, sizeof(int), &outPos);
+	}
+	//Swaps a folded kernel for Folded_Kernel's automated source, or back, setting its arguments again as a baked rebuild does. A baked kernel runs the//
+	//automated source while automated, as baking every buffer's new values would be a build per buffer, and is baked again afterwards//
+	void setFoldedAutomation(bool aIsAutomated)
+	{
+		if (!state_.isFoldedReady || isAutomatedReady_ == aIsAutomated)
+			return;
+
+		isAutomatedReady_ = false;
+		if (aIsAutomated)
+		{
+			createExplicitEquation(Folded_Kernel::source(state_.materials, false, true));
+			isAutomatedReady_ = errorStatus_ == CL_SUCCESS;
+		}
+		state_.isBakedReady = !isAutomatedReady_ && isBaked_;
+		if (!isAutomatedReady_)
+			createExplicitEquation(Folded_Kernel::source(state_.materials, state_.isBakedReady), state_.isBakedReady ? Folded_Kernel::bakedOptions(state_.materials) : "");
+
+		int inPos = model_->getInputPosition();
+		int outPos = model_->getOutputPosition();
+		state_.kernel.setArg(7, sizeof(int), &inPos);
+		state_.kernel.setArg(8, sizeof(int), &outPos);
+		std::map<std::string, cl_uint>::const_iterator coefficients = state_.kernelArguments.find(Folded_Kernel::coefficientsArgument);
+		if (coefficients != state_.kernelArguments.end())
+		{
+			if (state_.foldedCoefficientsBuffer() == nullptr)
+				state_.foldedCoefficientsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, Folded_Kernel::values(state_.materials).size() * sizeof(float));
+			state_.kernel.setArg(coefficients->second, sizeof(cl_mem), &state_.foldedCoefficientsBuffer);
+		}
+		isFoldedDirty_ = !state_.isBakedReady;
+	}
+	//Moves every automated coefficient on to the next aNumSteps samples. A folded kernel gets their folded values for each of those samples, written to//
+	//slot aSlot's table without waiting, as Folded_Kernel can't fold on the device. Everything else, the material table included, takes the values at the//
+	//first sample through updateCoefficient(), as does a dispatch switched to after automating, which getAutomationLabel() reports//
+	void applyAutomation(uint32_t aNumSteps, uint32_t aSlot)
+	{
+		if (automation_.empty())
+			return;
+
+		std::map<std::string, cl_uint>::const_iterator argument = state_.kernelArguments.find(Folded_Kernel::automationArgument);
+		if (isAutomatedReady_ && argument != state_.kernelArguments.end())
+		{
+			std::vector<float>& table = automationTables_[aSlot];
+			table.clear();
+			for (uint32_t i = 0; i != aNumSteps; ++i)
+			{
+				for (std::map<std::string, Automation_Stream>::const_iterator it = automation_.begin(); it != automation_.end(); ++it)
+					state_.materials.setCoefficient(it->first, it->second.valueAt(sampleClock_ + i));
+				std::vector<float> values = Folded_Kernel::values(state_.materials);
+				table.insert(table.end(), values.begin(), values.end());
+			}
+
+			size_t tableBytes = table.size() * sizeof(float);
+			if (automationBuffers_[aSlot]() == nullptr || automationBuffers_[aSlot].getInfo<CL_MEM_SIZE>() < tableBytes)
+				automationBuffers_[aSlot] = cl::Buffer(context_, CL_MEM_READ_ONLY, tableBytes);
+			commandQueue_.enqueueWriteBuffer(automationBuffers_[aSlot], CL_FALSE, 0, tableBytes, table.data());
+			state_.kernel.setArg(argument->second, sizeof(cl_mem), &automationBuffers_[aSlot]);
+		}
+
+		for (std::map<std::string, Automation_Stream>::const_iterator it = automation_.begin(); it != automation_.end(); ++it)
+			updateCoefficient(it->first, it->second.valueAt(sampleClock_));
+		sampleClock_ += aNumSteps;
+	}
+	void uploadMaterialTable()
+	{
+		const std::vector<Material_Coefficients>& coefficients = state_.materials.coefficientTable();
+		commandQueue_.enqueueWriteBuffer(state_.materialCoefficientsBuffer, CL_TRUE, 0, coefficients.size() * sizeof(Material_Coefficients), coefficients.data());
+		isMaterialTableDirty_ = false;
+	}
+	//Switches a folded kernel to its automated source here, so the build never lands inside fillBuffer(). False, with the reason, elsewhere//
+	bool beginAutomation(const std::string& aCoeff)
+	{
+		if (isAutomationSampleAccurate())
+			setFoldedAutomation(true);
+		if (isAutomatedReady_ && isAutomationSampleAccurate())
+			return true;
+
+		std::cout << "Automation of " << aCoeff << " refused - Only a folded dense kernel is sample accurate, not " << getDispatchLabel() << std::endl;
+		return false;
+	}
+	bool isHostImplementation() const
+	{
+		return implementation_ == Implementation::CPU || implementation_ == Implementation::CPU_SIMD;
+	}
 protected:
 public:
 	FDTD_Accelerated(Implementation aImplementation, uint32_t aDevice, uint32_t aSampleRate, float aGridSpacing) :
@@ -208,60 +978,254 @@ public:
 		excitationPosition_[0] = 32;
 		excitationPosition_[1] = 32;
 
-		initOpenCL();
+		if (isHostImplementation())
+			cpuEngine_ = new FDTD_CPU(implementation_ == Implementation::CPU_SIMD);
+		else
+			initOpenCL();
 	}
 	~FDTD_Accelerated()
 	{
-
+		delete cpuEngine_;
 	}
 
 	void buildProgram()
 	{
 		//Build program//
-		kernelProgram_.build();
+		state_.program.build();
 
-		kernel_ = cl::Kernel(kernelProgram_, "compute", &errorStatus_);	//@ToDo - Hard coded the kernel name. Find way to generate this?
+		state_.kernel = cl::Kernel(state_.program, "compute", &errorStatus_);	//@ToDo - Hard coded the kernel name. Find way to generate this?
 	}
 
+	//Taps set by setInputPositions()/setOutputPositions() run alongside - Their excitation comes from setInputs() and their samples go to getOutputs()//
 	void fillBuffer(float* input, float* output, uint32_t numSteps)
 	{
-		//Load excitation samples into GPU//
-		commandQueue_.enqueueWriteBuffer(excitationBuffer_, CL_TRUE, 0, numSteps * sizeof(float), input);
-		kernel_.setArg(5, sizeof(cl_mem), &excitationBuffer_);
-
-		//Calculate buffer size of synthesizer output samples//
-		for (unsigned int i = 0; i != numSteps; ++i)
+		applyAutomation(numSteps, 0);
+		if (numVoices_ != 0 && isBatchedReady_)
 		{
-			input[i] = 0.0;
-			//Increments kernel indices//
-			kernel_.setArg(4, sizeof(int), &output_.bufferIndex_);
-			kernel_.setArg(3, sizeof(int), &bufferRotationIndex_);
-
-			step();
+			fillVoices(input, output, numSteps);
+			return;
 		}
 
-		output_.resetIndex();
-		excitation_.resetIndex();
+		bool isTapped = !inputTaps_.empty() || !outputTaps_.empty();
+		if (isTapped)
+		{
+			tapInputs_.resize(numSteps * inputTaps_.size(), 0.0f);
+			tapOutputs_.resize(numSteps * outputTaps_.size());
+			numTapOutputSamples_ = numSteps;
+		}
+		if (isHostImplementation())
+		{
+			cpuEngine_->fillBuffer(input, output, numSteps, isTapped ? tapInputs_.data() : nullptr, isTapped ? tapOutputs_.data() : nullptr);
+			if (isTapped)
+				tapInputs_.clear();
+			return;
+		}
 
-		commandQueue_.enqueueReadBuffer(outputBuffer_, CL_TRUE, 0, numSteps * sizeof(float), output);
+		//Load excitation samples into GPU//
+		bool isProfiled = profileInterval_ != 0;
+		bool isBufferProfiled = this->isBufferProfiled();
+		uint32_t launchesBefore = numLaunches_;
+		launchEvents_.clear();
+		commandQueue_.enqueueWriteBuffer(excitationBuffer_, CL_TRUE, 0, numSteps * sizeof(float), input, NULL, isBufferProfiled ? &writeEvent_ : NULL);
+		memset(input, 0, numSteps * sizeof(float));
+		isTapping_ = isTapped && isTapKernelReady_;
+		if (isTapping_ && !inputTaps_.empty())
+			commandQueue_.enqueueWriteBuffer(tapInputBuffer_, CL_FALSE, 0, tapInputs_.size() * sizeof(float), tapInputs_.data());
+
+		enqueueSteps(excitationBuffer_, outputBuffer_, numSteps);
+
+		if (isTapping_ && !outputTaps_.empty())
+			commandQueue_.enqueueReadBuffer(tapOutputBuffer_, CL_FALSE, 0, tapOutputs_.size() * sizeof(float), tapOutputs_.data());
+		isTapping_ = false;
+		commandQueue_.enqueueReadBuffer(outputBuffer_, CL_TRUE, 0, numSteps * sizeof(float), output, NULL, isBufferProfiled ? &readEvent_ : NULL);
+		if (isTapped)
+			tapInputs_.clear();
+		if (isProfiled)
+			accumulateLaunchProfile(numLaunches_ - launchesBefore, isBufferProfiled);
 		//std::memcpy(output, output_.buffer_, sizeof(float) * (numSteps));
 		//for (int k = 0; k != numSteps; ++k)
 		//	output[k] = output_[k];
 
 		//float* temporaryGrid = new float[gridElements_ * 3];
-		//commandQueue_.enqueueReadBuffer(modelGrid_, CL_TRUE, 0, gridByteSize_ * 3, temporaryGrid);
+		//commandQueue_.enqueueReadBuffer(modelGrid, CL_TRUE, 0, gridByteSize_ * 3, temporaryGrid);
 		//render(temporaryGrid);
 
 		//delete temporaryGrid;
 	}
+	//fillBuffer() while batched - input and output hold numVoices_ interleaved channels//
+	void fillVoices(float* input, float* output, uint32_t numSteps)
+	{
+		bool isProfiled = profileInterval_ != 0;
+		bool isBufferProfiled = this->isBufferProfiled();
+		uint32_t launchesBefore = numLaunches_;
+		launchEvents_.clear();
+		commandQueue_.enqueueWriteBuffer(voiceInputBuffer_, CL_TRUE, 0, numSteps * numVoices_ * sizeof(float), input, NULL, isBufferProfiled ? &writeEvent_ : NULL);
+		memset(input, 0, numSteps * numVoices_ * sizeof(float));
+
+		stepBatched(numSteps);
+
+		commandQueue_.enqueueReadBuffer(voiceOutputBuffer_, CL_TRUE, 0, numSteps * numVoices_ * sizeof(float), output, NULL, isBufferProfiled ? &readEvent_ : NULL);
+		if (isProfiled)
+			accumulateLaunchProfile(numLaunches_ - launchesBefore, isBufferProfiled);
+	}
+	//Starts computing numSteps samples without waiting for them. At most two buffers may be in flight - collectBuffer() the oldest before submitting a third.//
+	//The excitation is copied, so input is zeroed and free for reuse as soon as this returns, as with fillBuffer(). False, leaving input as it was, when//
+	//both slots are still uncollected, as their staging copies may still be in transfer//
+	bool submitBuffer(float* input, uint32_t numSteps)
+	{
+		if (numSubmitted_ - numCollected_ >= numAsyncSlots_)
+		{
+			std::cout << "submitBuffer: " << numAsyncSlots_ << " buffers already in flight, collectBuffer() the oldest first" << std::endl;
+			return false;
+		}
+
+		uint32_t slot = numSubmitted_ % numAsyncSlots_;
+		asyncInputs_[slot].assign(input, input + numSteps);
+		asyncOutputs_[slot].resize(numSteps);
+		asyncNumSteps_[slot] = numSteps;
+		memset(input, 0, numSteps * sizeof(float));
+		++numSubmitted_;
+		applyAutomation(numSteps, slot);
+
+		if (isHostImplementation())
+		{
+			cpuEngine_->fillBuffer(asyncInputs_[slot].data(), asyncOutputs_[slot].data(), numSteps);
+			return true;
+		}
+
+		//Upload on the transfer queue while the previous buffer may still be computing//
+		transferQueue_.enqueueWriteBuffer(asyncExcitationBuffers_[slot], CL_FALSE, 0, numSteps * sizeof(float), asyncInputs_[slot].data(), NULL, &uploadEvents_[slot]);
+
+		//Steps wait for this buffer's upload only. Markers either side time the compute stage//
+		std::vector<cl::Event> uploaded(1, uploadEvents_[slot]);
+		commandQueue_.enqueueBarrierWithWaitList(&uploaded, &computeStartEvents_[slot]);
+		enqueueSteps(asyncExcitationBuffers_[slot], asyncOutputBuffers_[slot], numSteps);
+		commandQueue_.enqueueMarkerWithWaitList(NULL, &computeEndEvents_[slot]);
+		launchEvents_.clear();		//Pipelined buffers are timed by their markers instead//
+
+		//Read back on the transfer queue, overlapping the next buffer's compute//
+		std::vector<cl::Event> computed(1, computeEndEvents_[slot]);
+		transferQueue_.enqueueReadBuffer(asyncOutputBuffers_[slot], CL_FALSE, 0, numSteps * sizeof(float), asyncOutputs_[slot].data(), &computed, &readbackEvents_[slot]);
+
+		commandQueue_.flush();
+		transferQueue_.flush();
+		return true;
+	}
+	//Waits for the oldest submitted buffer and copies its samples into output. Returns the number of samples, 0 if nothing is in flight//
+	uint32_t collectBuffer(float* output)
+	{
+		if (numCollected_ == numSubmitted_)
+			return 0;
+
+		uint32_t slot = numCollected_ % numAsyncSlots_;
+		uint32_t numSteps = asyncNumSteps_[slot];
+		if (implementation_ == Implementation::OPENCL)
+		{
+			readbackEvents_[slot].wait();
+			uploadTime_ += commandDuration(uploadEvents_[slot]);
+			computeTime_ += eventDuration(computeStartEvents_[slot], computeEndEvents_[slot]);
+			readbackTime_ += commandDuration(readbackEvents_[slot]);
+		}
+		memcpy(output, asyncOutputs_[slot].data(), numSteps * sizeof(float));
+		++numCollected_;
+
+		return numSteps;
+	}
+	//Device time in ms each stage took over every collected buffer, so callers can compare against wall time to find how much of the transfer was hidden//
+	double getUploadTime() const
+	{
+		return uploadTime_;
+	}
+	double getComputeTime() const
+	{
+		return computeTime_;
+	}
+	double getReadbackTime() const
+	{
+		return readbackTime_;
+	}
+	void resetPipelineTimes()
+	{
+		uploadTime_ = 0.0;
+		computeTime_ = 0.0;
+		readbackTime_ = 0.0;
+	}
+	//Profiles every aInterval-th kernel launch of fillBuffer(), and every aInterval-th buffer's transfers, with OpenCL events - 1 profiles all of them,//
+	//0 turns profiling off. Events cost a little per launch, so sampling keeps the measurement from disturbing short buffers//
+	void setLaunchProfileInterval(uint32_t aInterval)
+	{
+		profileInterval_ = aInterval;
+		numLaunches_ = 0;
+	}
+	//Reads the events fillBuffer() kept into the totals first. Each fillBuffer ends on a blocking readback, so every one has completed//
+	const Launch_Profile& getLaunchProfile()
+	{
+		for (uint32_t i = 0; i != profiledLaunches_.size(); ++i)
+		{
+			cl_ulong queued = profiledLaunches_[i].getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+			cl_ulong submit = profiledLaunches_[i].getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>();
+			cl_ulong start = profiledLaunches_[i].getProfilingInfo<CL_PROFILING_COMMAND_START>();
+			cl_ulong end = profiledLaunches_[i].getProfilingInfo<CL_PROFILING_COMMAND_END>();
+			launchProfile_.queuedToSubmit += (submit - queued) / 1000000.0;
+			launchProfile_.submitToStart += (start - submit) / 1000000.0;
+			launchProfile_.kernelTime += (end - start) / 1000000.0;
+		}
+		for (uint32_t i = 0; i != profiledWrites_.size(); ++i)
+		{
+			launchProfile_.writeTime += commandDuration(profiledWrites_[i]);
+			launchProfile_.readTime += commandDuration(profiledReads_[i]);
+		}
+		launchProfile_.numProfiled += profiledLaunches_.size();
+		launchProfile_.numProfiledBuffers += profiledWrites_.size();
+		profiledLaunches_.clear();
+		profiledWrites_.clear();
+		profiledReads_.clear();
+		return launchProfile_;
+	}
+	void resetLaunchProfile()
+	{
+		launchProfile_ = Launch_Profile();
+		profiledLaunches_.clear();
+		profiledWrites_.clear();
+		profiledReads_.clear();
+	}
+
 	void renderSimulation()
 	{
-		commandQueue_.enqueueReadBuffer(modelGrid_, CL_TRUE, 0, gridByteSize_, renderGrid);
+		if (isHostImplementation())
+			memcpy(renderGrid, cpuEngine_->getGrid(), gridByteSize_);
+		else
+			commandQueue_.enqueueReadBuffer(state_.modelGrid, CL_TRUE, 0, gridByteSize_, renderGrid);
 		render(renderGrid);
 	}
 
 
-	void createModel(const std::string aPath, float aBoundaryValue, uint32_t aInputPosition[2], uint32_t aOutputPosition[2])
+	//Maps the .fdtm beside aPath, if one was converted. int32 id grids are used straight from the mapping, int8 ones are widened//
+	bool loadBinaryModel(const std::string aPath, Cached_Model& aModel)
+	{
+		aModel.file.reset(new Model_File());
+		if (!Model_File::isConverted(aPath) || !aModel.file->open(Model_File::binaryPath(aPath)))
+		{
+			aModel.file.reset();
+			return false;
+		}
+
+		aModel.width = aModel.file->width();
+		aModel.height = aModel.file->height();
+		if (aModel.file->idBytes() == 4)
+			aModel.idGrid = aModel.file->idGrid32();
+		else
+		{
+			aModel.idGridStorage.assign(aModel.file->idGrid8(), aModel.file->idGrid8() + aModel.width * aModel.height);
+			aModel.idGrid = aModel.idGridStorage.data();
+		}
+		aModel.boundaryGrid = aModel.file->boundaryGrid();
+		aModel.kernelSource = aModel.file->kernelSource();
+		json metadata = json::parse(aModel.file->metadata());
+		parseMaterialKernels(metadata["controllers"], aModel.kernelSource, aModel.materialKernels);
+		return true;
+	}
+	void loadJsonModel(const std::string aPath, Cached_Model& aModel)
 	{
 		// JOSN parsing.
 		//Read json file into program object//
@@ -269,44 +1233,105 @@ public:
 		json jsonFile = json::parse(ifs);
 		//std::cout << j << std::endl;
 
-		 modelWidth_ = jsonFile["buffer"].size();
-		 modelHeight_= jsonFile["buffer"][0].size();
+		aModel.width = jsonFile["buffer"].size();
+		aModel.height = jsonFile["buffer"][0].size();
 
-		 
-		 boundaryGridInput_ = new float[modelWidth_*modelHeight_];
-		 idGridInput_ = new int[modelWidth_*modelHeight_];
-		for (uint32_t i = 0; i != modelWidth_; ++i)
+		aModel.boundaryGridStorage.resize(aModel.width*aModel.height);
+		aModel.idGridStorage.resize(aModel.width*aModel.height);
+		aModel.boundaryGrid = aModel.boundaryGridStorage.data();
+		aModel.idGrid = aModel.idGridStorage.data();
+		for (uint32_t i = 0; i != aModel.width; ++i)
 		{
-			for (uint32_t j = 0; j != modelHeight_; ++j)
+			for (uint32_t j = 0; j != aModel.height; ++j)
 			{
-				idGridInput_[i*modelWidth_ + j] = jsonFile["buffer"][i][j];
+				aModel.idGrid[i*aModel.width + j] = jsonFile["buffer"][i][j];
 				//idGridInput_[i][j] = jsonFile["buffer"][i][j];
 				//std::cout << idGridInput_.valueAt(i, j) << " | ";
 			}
 			//std::cout << std::endl;
 		}
+		Model_File::fillEdgeBoundary(aModel.boundaryGrid, aModel.width, aModel.height);
 
-		globalws_ = cl::NDRange(modelWidth_, modelHeight_);
-		localws_ = cl::NDRange(8, 8);						//@ToDo - CHANGE TO OPTIMIZED GROUP SIZE.
-
-		//createExplicitEquation("2DWaveEquation2.cl");
-		//initRender();
-
-		model_ = new Model(modelWidth_, modelHeight_, aBoundaryValue);
-		model_->setInputPosition(aInputPosition[0], aInputPosition[1]);
-		model_->setOutputPosition(aOutputPosition[0], aOutputPosition[1]);
-
-		int boundaryCount = 0;
-		for (uint32_t i = 0; i != (modelWidth_); ++i)
+		aModel.kernelSource = jsonFile["controllers"][0]["physics_kernel"];
+		parseMaterialKernels(jsonFile["controllers"], aModel.kernelSource, aModel.materialKernels);
+	}
+	//Controllers whose physics_kernel defines an fdtdMaterialKernel run their id on their own under split dispatch.//
+	//aFirstKernel stands in for the first controller's source, which binary models keep outside the metadata//
+	static void parseMaterialKernels(const json& aControllers, const std::string& aFirstKernel, std::map<int, std::string>& aMaterialKernels)
+	{
+		aMaterialKernels.clear();
+		for (uint32_t i = 0; i != aControllers.size(); ++i)
 		{
-			for (uint32_t j = 0; j != (modelHeight_); ++j)
-			{
-				if(i == 0 || j == 0 || i == modelWidth_-1 || i == modelHeight_-1)
-					boundaryGridInput_[i*modelWidth_ + j] = 1.0;
-				else
-					boundaryGridInput_[i*modelWidth_ + j] = 0.0;
-			}
+			if (aControllers[i].count("id") == 0)
+				continue;
+			std::string source = i == 0 ? aFirstKernel : aControllers[i].value("physics_kernel", std::string());
+			if (source.find("fdtdMaterialKernel") != std::string::npos)
+				aMaterialKernels[aControllers[i]["id"].get<int>()] = source;
 		}
+	}
+	static std::filesystem::file_time_type modelWriteTime(const std::string& aPath)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type jsonTime = std::filesystem::last_write_time(aPath, error);
+		if (error)
+			jsonTime = std::filesystem::file_time_type::min();
+		std::filesystem::file_time_type binaryTime = std::filesystem::last_write_time(Model_File::binaryPath(aPath), error);
+		if (error)
+			binaryTime = std::filesystem::file_time_type::min();
+		return jsonTime > binaryTime ? jsonTime : binaryTime;
+	}
+	//Returns aPath's cache entry, loading the model first if it isn't cached or its file changed since. Least recently used models make room//
+	Cached_Model& loadModel(const std::string aPath)
+	{
+		std::filesystem::file_time_type writeTime = modelWriteTime(aPath);
+		std::map<std::string, Cached_Model>::iterator cached = modelCache_.find(aPath);
+		if (cached != modelCache_.end() && cached->second.writeTime == writeTime)
+		{
+			cached->second.lastUse = ++numModelLoads_;
+			return cached->second;
+		}
+
+		if (cached != modelCache_.end())
+			modelCache_.erase(cached);
+		while (!modelCache_.empty() && modelCache_.size() >= modelCacheCapacity_)
+		{
+			std::map<std::string, Cached_Model>::iterator oldest = modelCache_.begin();
+			for (std::map<std::string, Cached_Model>::iterator it = modelCache_.begin(); it != modelCache_.end(); ++it)
+				oldest = it->second.lastUse < oldest->second.lastUse ? it : oldest;
+			modelCache_.erase(oldest);
+		}
+
+		Cached_Model& model = modelCache_[aPath];
+		model.writeTime = writeTime;
+		model.lastUse = ++numModelLoads_;
+		if (!loadBinaryModel(aPath, model))
+			loadJsonModel(aPath, model);
+		return model;
+	}
+
+	//Loads aPath's binary twin when Model_File::convert() has produced one, otherwise parses the JSON.//
+	//Models already loaded come from the cache with their buffers and kernels intact - Only the grids are reset//
+	void createModel(const std::string aPath, float aBoundaryValue, uint32_t aInputPosition[2], uint32_t aOutputPosition[2])
+	{
+		Cached_Model& cachedModel = loadModel(aPath);
+		modelWidth_ = cachedModel.width;
+		modelHeight_ = cachedModel.height;
+		idGridInput_ = cachedModel.idGrid;
+		boundaryGridInput_ = cachedModel.boundaryGrid;
+
+		globalws_ = cl::NDRange(modelWidth_, modelHeight_);
+		localws_ = cl::NDRange(8, 8);						//Unless tuneWorkGroup() found a faster size on an earlier run//
+
+		//createExplicitEquation("2DWaveEquation2.cl");
+		//initRender();
+
+		if (!cachedModel.model || cachedModel.model->boundaryGain_ != aBoundaryValue)
+			cachedModel.model.reset(new Model(modelWidth_, modelHeight_, aBoundaryValue));
+		else
+			cachedModel.model->reset();
+		model_ = cachedModel.model.get();
+
+		int boundaryCount = 0;
 		int gridUseCount = 0;
 		for (uint32_t i = 1; i != (modelWidth_- 1); ++i)
 		{
@@ -390,71 +1415,786 @@ public:
 
 		gridElements_ = (modelWidth_ * modelHeight_);
 		gridByteSize_ = (gridElements_ * sizeof(float));
+		delete[] renderGrid;
 		renderGrid = new float[gridElements_];
 
+		//Buffers still in flight belong to the previous model. Drained first, so no transfer is left writing their staging copies//
 		if (implementation_ == Implementation::OPENCL)
 		{
-			initBuffersCL();
+			commandQueue_.finish();
+			transferQueue_.finish();
 		}
+		numSubmitted_ = 0;
+		numCollected_ = 0;
+		bufferRotationIndex_ = 1;
+
+		//Automation names the previous model's coefficients. Cached kernels are never the automated source//
+		automation_.clear();
+		sampleClock_ = 0;
+		isAutomatedReady_ = false;
+		output_.resetIndex();
+		excitation_.resetIndex();
+
+		initConnections();
+		if (implementation_ == Implementation::OPENCL)
+		{
+			if (cachedModel.isBuilt)
+			{
+				restoreModelState(cachedModel);
+				resetModelGrids();
+
+				//Cached kernels may have been folded differently//
+				if (state_.isFoldedReady != isFolded_ || state_.isBakedReady != (isFolded_ && isBaked_))
+				{
+					createExplicitEquation(cachedModel.kernelSource);
+					createFoldedEquation(cachedModel.kernelSource);
+					storeModelState(cachedModel);
+				}
+
+				//Cached pitched grids may have been built at another precision//
+				if (state_.pitchedOptions != pitchedBuildOptions())
+				{
+					createPitchedEquation();
+					storeModelState(cachedModel);
+				}
+			}
+			else
+			{
+				//Built from nothing, so no handle or flag of the previous model carries over//
+				state_ = Model_State();
+				initBuffersCL();
+				createExplicitEquation(cachedModel.kernelSource);
+				createMaterialTable(cachedModel.kernelSource);
+				createFoldedEquation(cachedModel.kernelSource);
+				createBlockedEquation();
+				createPersistentEquation();
+				createSparseEquation();
+				createSplitEquation(cachedModel.materialKernels);
+				createPitchedEquation();
+				storeModelState(cachedModel);
+			}
+			workGroupKey_ = Work_Group_Tuner::makeKey(device_, cachedModel.kernelSource, modelWidth_, modelHeight_);
+			Work_Group_Tuner::lookup(workGroupKey_, localws_);
 
-		createExplicitEquation(aPath);
+			//The model's fdtdKernel takes the grid size from its global range, so that stays exact and the local size has to divide it//
+			localws_ = cl::NDRange(powerOfTwoDivisor(modelWidth_, localws_.get()[0]), powerOfTwoDivisor(modelHeight_, localws_.get()[1]));
+		}
+		else if (isHostImplementation())
+		{
+			cpuEngine_->createModel(model_, idGridInput_, cachedModel.kernelSource, connections_, numConnections_);
+		}
+
+		int inputPosition[2] = { (int)aInputPosition[0], (int)aInputPosition[1] };
+		int outputPosition[2] = { (int)aOutputPosition[0], (int)aOutputPosition[1] };
+		setInputPosition(inputPosition);
+		setOutputPosition(outputPosition);
+		uploadTaps();
+		if (implementation_ == Implementation::OPENCL)
+			createBatchedEquation();
+	}
+	//Drops every cached program and every cached model bar the current one, releasing their device memory//
+	void clearModelCache()
+	{
+		for (std::map<std::string, Cached_Model>::iterator it = modelCache_.begin(); it != modelCache_.end();)
+			it = it->second.model.get() == model_ ? std::next(it) : modelCache_.erase(it);
+		programCache_.clear();
+	}
+	//Models kept loaded at once. Sweeps alternating between n models want at least n//
+	void setModelCacheCapacity(uint32_t aCapacity)
+	{
+		modelCacheCapacity_ = aCapacity == 0 ? 1 : aCapacity;
 	}
 
-	void createExplicitEquation(const std::string aPath)
+	//aPhysicsKernel is the model's fdtdKernel source, as loaded by createModel()//
+	void createExplicitEquation(const std::string& aPhysicsKernel, const std::string& aOptions = "")
 	{
-		//Read json file into program object//
-		std::ifstream ifs(aPath);
-		json jsonFile = json::parse(ifs);
 		//@TODO - Fix which physics equation is collected.
-		//std::string sourceFile = jsonFile["controllers"][0]["physics_kernel"];
-		std::string sourceFile = jsonFile["controllers"][0]["physics_kernel"];
-
-		std::cout << sourceFile << std::endl;
+		const std::string& sourceFile = aPhysicsKernel;
 
 		//Read in program source//
 		//kernelSourcePath_ = aPath;
 		//std::ifstream sourceFileName(kernelSourcePath_.c_str());
 		//std::string sourceFile(std::istreambuf_iterator<char>(sourceFileName), (std::istreambuf_iterator<char>()));
 
-		//Create program source object from std::string source code//
-		std::vector<std::string> programSources;
-		programSources.push_back(sourceFile);
-		cl::Program::Sources source(programSources);	//Apparently this takes a vector of strings as the program source.
-
-		//Create program from source code//
-		kernelProgram_ = cl::Program(context_, source, &errorStatus_);
-		if (errorStatus_)
-			std::cout << "ERROR creating program from source. Status code: " << errorStatus_ << std::endl;
-		
-		//Build program//
-		char options[1024];
-		snprintf(options, sizeof(options),
-			""
+		//Build program - With argument names kept, for mapKernelArguments()//
+		std::string options = aOptions.empty() ? "-cl-kernel-arg-info" : aOptions + " -cl-kernel-arg-info";
 			//" -cl-fast-relaxed-math"
 			//" -cl-single-precision-constant"
-			//""
-		);
-		kernelProgram_.build();	//@Highlight - Keep this in?
+		if (!getProgram(sourceFile, options, state_.program))
+			std::cout << "ERROR creating program from source. Status code: " << errorStatus_ << std::endl;
 
-		kernel_ = cl::Kernel(kernelProgram_, "fdtdKernel", &errorStatus_);	//@ToDo - Hard coded the kernel name. Find way to generate this?
+		state_.kernel = cl::Kernel(state_.program, "fdtdKernel", &errorStatus_);	//@ToDo - Hard coded the kernel name. Find way to generate this?
 		//buildProgram();
 
 		if (errorStatus_)
 			std::cout << "ERROR building program from source. Status code: " << errorStatus_ << std::endl;
+		else
+			mapKernelArguments(sourceFile);
+
+		state_.kernel.setArg(0, sizeof(cl_mem), &state_.idGridBuffer);
+		state_.kernel.setArg(1, sizeof(cl_mem), &state_.modelGrid);
+		state_.kernel.setArg(2, sizeof(cl_mem), &state_.boundaryGridBuffer);
+		state_.kernel.setArg(6, sizeof(cl_mem), &outputBuffer_);
+
+		//CONNECTIONS - Only kernels taking them, as the simple models have coefficients in these places//
+		std::map<std::string, cl_uint>::const_iterator numConnections = state_.kernelArguments.find("numConnections");
+		std::map<std::string, cl_uint>::const_iterator connections = state_.kernelArguments.find("connections");
+		if (numConnections != state_.kernelArguments.end())
+			state_.kernel.setArg(numConnections->second, sizeof(int), &numConnections_);
+		if (connections != state_.kernelArguments.end())
+			state_.kernel.setArg(connections->second, sizeof(cl_mem), &connectionsBuffer_);
+	}
+	//Fills kernelArguments for kernel from CL_KERNEL_ARG_NAME. Programs Program_Binary_Cache loaded from a binary have no argument info, so for those//
+	//the names come from fdtdKernel's signature in aSource//
+	void mapKernelArguments(const std::string& aSource)
+	{
+		state_.kernelArguments.clear();
+		cl_int status = CL_SUCCESS;
+		cl_uint numArguments = state_.kernel.getInfo<CL_KERNEL_NUM_ARGS>(&status);
+		for (cl_uint i = 0; status == CL_SUCCESS && i != numArguments; ++i)
+		{
+			std::string name = state_.kernel.getArgInfo<CL_KERNEL_ARG_NAME>(i, &status);
+			state_.kernelArguments[name.c_str()] = i;
+		}
+		if (status != CL_SUCCESS)
+			state_.kernelArguments = parseKernelArguments(aSource, "fdtdKernel");
+	}
+	//Argument indices by name from aKernelName's parameter list in aSource//
+	static std::map<std::string, cl_uint> parseKernelArguments(const std::string& aSource, const std::string& aKernelName)
+	{
+		std::map<std::string, cl_uint> arguments;
+		size_t start = aSource.find(aKernelName + "(");
+		size_t end = aSource.find(')', start);
+		if (start == std::string::npos || end == std::string::npos)
+			return arguments;
+
+		start += aKernelName.size() + 1;
+		std::stringstream parameters(aSource.substr(start, end - start));
+		std::string parameter;
+		for (cl_uint i = 0; std::getline(parameters, parameter, ','); ++i)
+		{
+			size_t last = parameter.find_last_not_of(" \t\r\n");
+			size_t first = parameter.find_last_of(" \t\r\n*", last);
+			if (last != std::string::npos)
+				arguments[parameter.substr(first == std::string::npos ? 0 : first + 1, last - (first == std::string::npos ? 0 : first + 1) + 1)] = i;
+		}
+		return arguments;
+	}
+	//Swaps kernel for Folded_Kernel's source once the material table is parsed, keeping aPhysicsKernel if that fails to build. Arguments 0-10 match//
+	//the model kernel's, so everything setting those carries on. The coefficients follow from the next fillBuffer//
+	void createFoldedEquation(const std::string& aPhysicsKernel)
+	{
+		state_.isFoldedReady = false;
+		state_.isBakedReady = false;
+		isAutomatedReady_ = false;
+		if (!isFolded_ || !isMaterialTableExact())
+			return;
+
+		createExplicitEquation(Folded_Kernel::source(state_.materials, isBaked_), isBaked_ ? Folded_Kernel::bakedOptions(state_.materials) : "");
+		state_.isFoldedReady = errorStatus_ == CL_SUCCESS;
+		state_.isBakedReady = state_.isFoldedReady && isBaked_;
+		isFoldedDirty_ = state_.isFoldedReady && !state_.isBakedReady;
+		if (!state_.isFoldedReady)
+		{
+			createExplicitEquation(aPhysicsKernel);
+			return;
+		}
 
-		kernel_.setArg(0, sizeof(cl_mem), &idGrid_);
-		kernel_.setArg(1, sizeof(cl_mem), &modelGrid_);
-		kernel_.setArg(2, sizeof(cl_mem), &boundaryGridBuffer_);
-		kernel_.setArg(6, sizeof(cl_mem), &outputBuffer_);
+		std::map<std::string, cl_uint>::const_iterator coefficients = state_.kernelArguments.find(Folded_Kernel::coefficientsArgument);
+		if (coefficients != state_.kernelArguments.end())
+		{
+			state_.foldedCoefficientsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, Folded_Kernel::values(state_.materials).size() * sizeof(float));
+			state_.kernel.setArg(coefficients->second, sizeof(cl_mem), &state_.foldedCoefficientsBuffer);
+		}
+	}
+	//Built program for aSource and aOptions. Each source, options and device combination is built once per run, so models sharing a kernel share the build.//
+	//Builds come from Program_Binary_Cache, which skips the compiler when an earlier run left a matching binary//
+	bool getProgram(const std::string& aSource, const std::string& aOptions, cl::Program& aProgram)
+	{
+		char hashes[40];
+		snprintf(hashes, sizeof(hashes), "%016llx_%016llx", (unsigned long long)Program_Binary_Cache::hashString(aSource), (unsigned long long)Program_Binary_Cache::hashString(aOptions));
+		std::string key = std::string(hashes) + "_" + device_.getInfo<CL_DEVICE_NAME>();
 
-		int inPos = model_->getInputPosition();
-		int outPos = model_->getOutputPosition();
-		kernel_.setArg(7, sizeof(int), &inPos);
-		kernel_.setArg(8, sizeof(int), &outPos);
+		std::map<std::string, cl::Program>::iterator cached = programCache_.find(key);
+		if (cached != programCache_.end())
+		{
+			aProgram = cached->second;
+			return true;
+		}
+
+		errorStatus_ = Program_Binary_Cache::build(context_, aSource, aOptions, aProgram);
+		if (errorStatus_ != CL_SUCCESS)
+			return false;
+
+		programCache_[key] = aProgram;
+		return true;
+	}
+	//Source of a kernel file under resources/kernels, behind the shared definitions and stencil of commonKernelPath_//
+	std::string readKernelSource(const std::string& aPath) const
+	{
+		std::ifstream commonFile(commonKernelPath_.c_str());
+		std::ifstream sourceFileName(aPath.c_str());
+		return std::string(std::istreambuf_iterator<char>(commonFile), (std::istreambuf_iterator<char>()))
+			+ std::string(std::istreambuf_iterator<char>(sourceFileName), (std::istreambuf_iterator<char>()));
+	}
+	//Builds a kernel from a source file under resources/kernels. Returns false, leaving aKernel untouched, if any stage fails//
+	bool createKernelFromFile(const std::string& aPath, const std::string& aKernelName, const std::string& aOptions, cl::Program& aProgram, cl::Kernel& aKernel)
+	{
+		std::string sourceFile = readKernelSource(aPath);
+		if (getProgram(sourceFile, aOptions, aProgram))
+			aKernel = cl::Kernel(aProgram, aKernelName.c_str(), &errorStatus_);
+		if (errorStatus_)
+			std::cout << "ERROR building " << aKernelName << " from " << aPath << ". Status code: " << errorStatus_ << std::endl;
+		return errorStatus_ == CL_SUCCESS;
+	}
+	//Folds the materials used by aPhysicsKernel into the per id tables read by the blocked and persistent kernels//
+	void createMaterialTable(const std::string& aPhysicsKernel)
+	{
+		int maxId = 0;
+		for (int i = 0; i != gridElements_; ++i)
+			maxId = idGridInput_[i] > maxId ? idGridInput_[i] : maxId;
+		state_.materials.parseKernel(aPhysicsKernel, maxId);
+		if (!isMaterialTableExact())
+			std::cout << "Generic dispatch unavailable - The model's fdtdKernel doesn't weight each neighbour by its own boundary" << std::endl;
+
+		//Types never change for a model, coefficients are re-uploaded whenever updateCoefficient() touches them//
+		std::vector<int> types(state_.materials.types().begin(), state_.materials.types().end());
+		state_.materialTypesBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, types.size() * sizeof(int));
+		state_.materialCoefficientsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, types.size() * sizeof(Material_Coefficients));
+		commandQueue_.enqueueWriteBuffer(state_.materialTypesBuffer, CL_TRUE, 0, types.size() * sizeof(int), types.data());
+		uploadMaterialTable();
+	}
+	//Every path but the model's own fdtdKernel steps the material table through MATERIAL_STENCIL, weighting each neighbour by its own boundary. Models//
+	//whose kernel reads neighbours unweighted or mirrors rows would get other physics, so they keep their own kernel whatever dispatch is asked for//
+	bool isMaterialTableExact() const
+	{
+		return state_.materials.isBoundaryWeighted() && !state_.materials.isRowMirrored();
+	}
+	//Prepares fdtdBlockedKernel. Models with connections need every step to see the others, so keep the per sample kernel//
+	void createBlockedEquation()
+	{
+		state_.isBlockable = state_.materials.connections().empty() && !state_.materials.usesConnectionBuffer() && isMaterialTableExact();
+		if (!state_.isBlockable)
+			return;
+
+		state_.isBlockable = createKernelFromFile(blockedKernelPath_, "fdtdBlockedKernel", "", state_.blockedProgram, state_.blockedKernel);
+		if (!state_.isBlockable)
+			return;
+
+		int numMaterials = state_.materials.types().size();
+		state_.modelGridBack = cl::Buffer(context_, CL_MEM_READ_WRITE, gridByteSize_ * 3);
+		commandQueue_.enqueueFillBuffer(state_.modelGridBack, 0.0f, 0, gridByteSize_ * 3);
+
+		//Whole tiles cover the grid - Work-items past the edge only help load the halo//
+		uint32_t tileSize = device_.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() < blockTileSize_ * blockTileSize_ ? blockTileSize_ / 2 : blockTileSize_;
+		state_.blockedLocalws = cl::NDRange(tileSize, tileSize);
+		state_.blockedGlobalws = cl::NDRange((modelWidth_ + tileSize - 1) / tileSize * tileSize, (modelHeight_ + tileSize - 1) / tileSize * tileSize);
+
+		uint64_t localMemorySize = device_.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+		uint32_t radius = state_.materials.stencilRadius();
+		state_.maxStepsPerLaunch = 1;
+		while (true)
+		{
+			uint64_t side = tileSize + 2 * radius * (state_.maxStepsPerLaunch + 1);
+			if (side * side * (3 * sizeof(float) + sizeof(int)) > localMemorySize)
+				break;
+			++state_.maxStepsPerLaunch;
+		}
+
+		int width = modelWidth_;
+		int height = modelHeight_;
+		int stencilRadius = radius;
+		state_.blockedKernel.setArg(0, sizeof(cl_mem), &state_.idGridBuffer);
+		state_.blockedKernel.setArg(3, sizeof(cl_mem), &state_.boundaryGridBuffer);
+		state_.blockedKernel.setArg(7, sizeof(cl_mem), &excitationBuffer_);
+		state_.blockedKernel.setArg(8, sizeof(cl_mem), &outputBuffer_);
+		state_.blockedKernel.setArg(11, sizeof(cl_mem), &state_.materialTypesBuffer);
+		state_.blockedKernel.setArg(12, sizeof(cl_mem), &state_.materialCoefficientsBuffer);
+		state_.blockedKernel.setArg(13, sizeof(int), &numMaterials);
+		state_.blockedKernel.setArg(14, sizeof(int), &stencilRadius);
+		state_.blockedKernel.setArg(15, sizeof(int), &width);
+		state_.blockedKernel.setArg(16, sizeof(int), &height);
+	}
+	//Hard coded and buffer connections as (source, destination) pairs, the form the persistent and sparse kernels apply them in. Pairs naming a cell//
+	//off this grid, as the buffer's 512 grid indices do on smaller models, are dropped rather than written past it//
+	std::vector<int> connectionPairs() const
+	{
+		std::vector<int> pairs;
+		for (uint32_t i = 0; i != state_.materials.connections().size(); ++i)
+		{
+			pairs.push_back(state_.materials.connections()[i].first);
+			pairs.push_back(state_.materials.connections()[i].second);
+		}
+		if (state_.materials.usesConnectionBuffer())
+			pairs.insert(pairs.end(), connections_, connections_ + numConnections_);
+
+		std::vector<int> connections;
+		for (uint32_t i = 0; i + 1 < pairs.size(); i += 2)
+		{
+			if (pairs[i] >= 0 && pairs[i] < gridElements_ && pairs[i + 1] >= 0 && pairs[i + 1] < gridElements_)
+			{
+				connections.push_back(pairs[i]);
+				connections.push_back(pairs[i + 1]);
+			}
+		}
+		return connections;
+	}
+	//Prepares fdtdPersistentKernel. Levels are kept in local memory when two grids fit, otherwise the kernel works on modelGrid directly//
+	void createPersistentEquation()
+	{
+		state_.isPersistentReady = false;
+		if (!isMaterialTableExact())
+			return;
+
+		bool isResident = isPersistentResident(modelWidth_, modelHeight_);
+		state_.isPersistentReady = createKernelFromFile(persistentKernelPath_, "fdtdPersistentKernel", isResident ? "-DRESIDENT_LEVELS" : "", state_.persistentProgram, state_.persistentKernel);
+		if (!state_.isPersistentReady)
+			return;
+
+		//Hard coded and buffer connections are both applied inside the kernel//
+		std::vector<int> connections = connectionPairs();
+		int numConnections = connections.size();
+		state_.persistentConnectionsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, (connections.size() + 1) * sizeof(int));
+		if (numConnections != 0)
+			commandQueue_.enqueueWriteBuffer(state_.persistentConnectionsBuffer, CL_TRUE, 0, connections.size() * sizeof(int), connections.data());
+
+		size_t groupSize = state_.persistentKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device_);
+		groupSize = groupSize < (size_t)gridElements_ ? groupSize : gridElements_;
+		state_.persistentws = cl::NDRange(groupSize);
+
+		int numMaterials = state_.materials.types().size();
+		int radius = state_.materials.stencilRadius();
+		int width = modelWidth_;
+		int height = modelHeight_;
+		state_.persistentKernel.setArg(0, sizeof(cl_mem), &state_.idGridBuffer);
+		state_.persistentKernel.setArg(2, sizeof(cl_mem), &state_.boundaryGridBuffer);
+		state_.persistentKernel.setArg(6, sizeof(cl_mem), &excitationBuffer_);
+		state_.persistentKernel.setArg(7, sizeof(cl_mem), &outputBuffer_);
+		state_.persistentKernel.setArg(10, sizeof(cl_mem), &state_.materialTypesBuffer);
+		state_.persistentKernel.setArg(11, sizeof(cl_mem), &state_.materialCoefficientsBuffer);
+		state_.persistentKernel.setArg(12, sizeof(int), &numMaterials);
+		state_.persistentKernel.setArg(13, sizeof(int), &radius);
+		state_.persistentKernel.setArg(14, sizeof(int), &width);
+		state_.persistentKernel.setArg(15, sizeof(int), &height);
+		state_.persistentKernel.setArg(16, sizeof(int), &numConnections);
+		state_.persistentKernel.setArg(17, sizeof(cl_mem), &state_.persistentConnectionsBuffer);
+		state_.persistentKernel.setArg(18, cl::Local(isResident ? gridByteSize_ : sizeof(float)));
+		state_.persistentKernel.setArg(19, cl::Local(isResident ? gridByteSize_ : sizeof(float)));
+	}
+	//Prepares fdtdSparseKernel - Lists the cells a step can change. Everything else is empty, stays zero and is never dispatched//
+	void createSparseEquation()
+	{
+		state_.isSparseReady = false;
+		if (!isMaterialTableExact())
+			return;
+
+		state_.isSparseReady = createKernelFromFile(sparseKernelPath_, "fdtdSparseKernel", "", state_.sparseProgram, state_.sparseKernel);
+		if (state_.isSparseReady)
+			state_.sparseConnectionsKernel = cl::Kernel(state_.sparseProgram, "fdtdSparseConnections", &errorStatus_);
+		state_.isSparseReady = state_.isSparseReady && errorStatus_ == CL_SUCCESS;
+		if (!state_.isSparseReady)
+			return;
+
+		int radius = state_.materials.stencilRadius();
+		int numMaterials = state_.materials.types().size();
+		std::vector<char> isActive(gridElements_, 0);
+		for (int y = radius; y < modelHeight_ - radius; ++y)
+		{
+			for (int x = radius; x < modelWidth_ - radius; ++x)
+			{
+				int id = idGridInput_[y * modelWidth_ + x];
+				isActive[y * modelWidth_ + x] = id > 0 && id < numMaterials && state_.materials.types()[id] != 0;
+			}
+		}
+		std::vector<int> connections = connectionPairs();
+		for (uint32_t i = 1; i < connections.size(); i += 2)
+			isActive[connections[i]] = 1;
+		state_.activeModelCells.clear();
+		for (int i = 0; i != gridElements_; ++i)
+		{
+			if (isActive[i])
+				state_.activeModelCells.push_back(i);
+		}
 
-		//CONNECTIONS
-		kernel_.setArg(9, sizeof(int), &numConnections_);
-		kernel_.setArg(10, sizeof(cl_mem), &connectionsBuffer_);
+		//Room for every bucket's padding and the excitation cell//
+		state_.activeCellsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, (state_.activeModelCells.size() + (numMaterials + 1) * sparseGroupSize_ + 1) * sizeof(int));
+		state_.numSparseConnections = connections.size();
+		state_.sparseConnectionsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, (connections.size() + 1) * sizeof(int));
+		if (state_.numSparseConnections != 0)
+			commandQueue_.enqueueWriteBuffer(state_.sparseConnectionsBuffer, CL_TRUE, 0, connections.size() * sizeof(int), connections.data());
+
+		int width = modelWidth_;
+		int height = modelHeight_;
+		int gridSize = gridElements_;
+		state_.sparseKernel.setArg(0, sizeof(cl_mem), &state_.idGridBuffer);
+		state_.sparseKernel.setArg(2, sizeof(cl_mem), &state_.boundaryGridBuffer);
+		state_.sparseKernel.setArg(5, sizeof(cl_mem), &excitationBuffer_);
+		state_.sparseKernel.setArg(6, sizeof(cl_mem), &outputBuffer_);
+		state_.sparseKernel.setArg(9, sizeof(cl_mem), &state_.materialTypesBuffer);
+		state_.sparseKernel.setArg(10, sizeof(cl_mem), &state_.materialCoefficientsBuffer);
+		state_.sparseKernel.setArg(11, sizeof(int), &numMaterials);
+		state_.sparseKernel.setArg(12, sizeof(int), &radius);
+		state_.sparseKernel.setArg(13, sizeof(int), &width);
+		state_.sparseKernel.setArg(14, sizeof(int), &height);
+		state_.sparseKernel.setArg(15, sizeof(cl_mem), &state_.activeCellsBuffer);
+		state_.sparseConnectionsKernel.setArg(2, sizeof(int), &gridSize);
+		state_.sparseConnectionsKernel.setArg(3, sizeof(int), &state_.numSparseConnections);
+		state_.sparseConnectionsKernel.setArg(4, sizeof(cl_mem), &state_.sparseConnectionsBuffer);
+	}
+	//Prepares split dispatch - A launch per material id over that id's cells, so no work-item branches on material. Ids whose controller supplies//
+	//an fdtdMaterialKernel run it, the rest the built-in one specialised for their type. Both are built with -DMATERIAL_TYPE=n//
+	void createSplitEquation(const std::map<int, std::string>& aMaterialKernels)
+	{
+		state_.materialLaunches.clear();
+		state_.isSplitReady = false;
+		if (!isMaterialTableExact())
+			return;
+
+		cl::Program couplingProgram;
+		state_.isSplitReady = createKernelFromFile(materialKernelPath_, "fdtdCouplingKernel", "", couplingProgram, state_.couplingKernel);
+		if (!state_.isSplitReady)
+			return;
+
+		std::string builtInSource = readKernelSource(materialKernelPath_);
+
+		int radius = state_.materials.stencilRadius();
+		int numMaterials = state_.materials.types().size();
+		int width = modelWidth_;
+		int height = modelHeight_;
+		state_.materialCells.clear();
+		for (int id = 1; id < numMaterials; ++id)
+		{
+			std::map<int, std::string>::const_iterator custom = aMaterialKernels.find(id);
+			if (custom == aMaterialKernels.end() && state_.materials.types()[id] == 0)
+				continue;
+
+			Material_Launch launch;
+			launch.id = id;
+			launch.firstCell = state_.materialCells.size();
+			for (int y = radius; y < modelHeight_ - radius; ++y)
+			{
+				for (int x = radius; x < modelWidth_ - radius; ++x)
+				{
+					if (idGridInput_[y * modelWidth_ + x] == id)
+						state_.materialCells.push_back(y * modelWidth_ + x);
+				}
+			}
+			launch.numCells = state_.materialCells.size() - launch.firstCell;
+			if (launch.numCells == 0)
+				continue;
+
+			cl::Program program;
+			std::string options = "-DMATERIAL_TYPE=" + std::to_string(state_.materials.types()[id]);
+			if (getProgram(custom == aMaterialKernels.end() ? builtInSource : custom->second, options, program))
+				launch.kernel = cl::Kernel(program, "fdtdMaterialKernel", &errorStatus_);
+			if (errorStatus_ != CL_SUCCESS)
+			{
+				std::cout << "ERROR building fdtdMaterialKernel for material " << id << ". Status code: " << errorStatus_ << std::endl;
+				state_.isSplitReady = false;
+				return;
+			}
+			launch.globalws = cl::NDRange((launch.numCells + sparseGroupSize_ - 1) / sparseGroupSize_ * sparseGroupSize_);
+			state_.materialLaunches.push_back(launch);
+		}
+		state_.materialCellsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, (state_.materialCells.size() + 1) * sizeof(int));
+		if (!state_.materialCells.empty())
+			commandQueue_.enqueueWriteBuffer(state_.materialCellsBuffer, CL_TRUE, 0, state_.materialCells.size() * sizeof(int), state_.materialCells.data());
+
+		std::vector<int> connections = connectionPairs();
+		int numConnections = connections.size();
+		state_.splitClearCells.clear();
+		for (uint32_t i = 1; i < connections.size(); i += 2)
+		{
+			if (std::find(state_.materialCells.begin(), state_.materialCells.end(), connections[i]) == state_.materialCells.end()
+				&& std::find(state_.splitClearCells.begin(), state_.splitClearCells.end(), connections[i]) == state_.splitClearCells.end())
+				state_.splitClearCells.push_back(connections[i]);
+		}
+		state_.couplingConnectionsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, (connections.size() + 1) * sizeof(int));
+		if (numConnections != 0)
+			commandQueue_.enqueueWriteBuffer(state_.couplingConnectionsBuffer, CL_TRUE, 0, connections.size() * sizeof(int), connections.data());
+		state_.couplingCellsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, (state_.splitClearCells.size() + 1) * sizeof(int));
+
+		for (uint32_t i = 0; i != state_.materialLaunches.size(); ++i)
+		{
+			cl::Kernel& kernel = state_.materialLaunches[i].kernel;
+			kernel.setArg(1, sizeof(cl_mem), &state_.boundaryGridBuffer);
+			kernel.setArg(3, sizeof(int), &width);
+			kernel.setArg(4, sizeof(int), &height);
+			kernel.setArg(5, sizeof(cl_mem), &state_.materialCellsBuffer);
+			kernel.setArg(6, sizeof(int), &state_.materialLaunches[i].firstCell);
+			kernel.setArg(7, sizeof(int), &state_.materialLaunches[i].numCells);
+			kernel.setArg(8, sizeof(cl_mem), &state_.materialCoefficientsBuffer);
+			kernel.setArg(9, sizeof(int), &state_.materialLaunches[i].id);
+		}
+		int gridSize = gridElements_;
+		state_.couplingKernel.setArg(3, sizeof(int), &gridSize);
+		state_.couplingKernel.setArg(4, sizeof(cl_mem), &excitationBuffer_);
+		state_.couplingKernel.setArg(5, sizeof(cl_mem), &outputBuffer_);
+		state_.couplingKernel.setArg(8, sizeof(cl_mem), &state_.couplingCellsBuffer);
+		state_.couplingKernel.setArg(10, sizeof(cl_mem), &state_.couplingConnectionsBuffer);
+		state_.couplingKernel.setArg(11, sizeof(int), &numConnections);
+	}
+	//Largest power of two dividing aN, up to aLimit//
+	static size_t powerOfTwoDivisor(size_t aN, size_t aLimit)
+	{
+		size_t divisor = 1;
+		while (divisor * 2 <= aLimit && aN % (divisor * 2) == 0)
+			divisor *= 2;
+		return divisor;
+	}
+	//Cell (x, y) of the current model in the pitched grids, -1 off the grid//
+	int pitchedIndex(int x, int y) const
+	{
+		return x >= 0 && x < modelWidth_ && y >= 0 && y < modelHeight_ ? y * state_.pitch + x : -1;
+	}
+	static size_t storageSize(StoragePrecision aPrecision)
+	{
+		return aPrecision == STORAGE_HALF ? 2 : (aPrecision == STORAGE_DOUBLE ? 8 : 4);
+	}
+	//Masks stand in for the boundary weights only where every weight is 0 or 1, as fillEdgeBoundary() leaves them//
+	bool isBoundaryBinary() const
+	{
+		for (int i = 0; i != gridElements_; ++i)
+		{
+			if (boundaryGridInput_[i] != 0.0f && boundaryGridInput_[i] != 1.0f)
+				return false;
+		}
+		return true;
+	}
+	//Bytes per cell of the pitched boundary grid - A float weight, or a mask of 8 neighbours, 12 with the plate's outer ring//
+	size_t neighbourMaskSize() const
+	{
+		if (!isNeighbourMasked_ || !isBoundaryBinary())
+			return sizeof(float);
+		return state_.materials.stencilRadius() > 1 ? sizeof(cl_ushort) : sizeof(cl_uchar);
+	}
+	//The id storage the pitched layout can actually use - 8 bits need every sanitised id, below the material count, to fit, and the image needs image//
+	//support, a CL_R, CL_UNSIGNED_INT8 format and a grid within the device's image size. Each falls back to the next wider//
+	IdStorage pitchedIdStorage() const
+	{
+		if (idStorage_ == ID_INT || state_.materials.types().size() > 256)
+			return ID_INT;
+		if (idStorage_ == ID_IMAGE && device_.getInfo<CL_DEVICE_IMAGE_SUPPORT>() && (size_t)modelWidth_ <= device_.getInfo<CL_DEVICE_IMAGE2D_MAX_WIDTH>()
+			&& (size_t)modelHeight_ <= device_.getInfo<CL_DEVICE_IMAGE2D_MAX_HEIGHT>())
+		{
+			std::vector<cl::ImageFormat> formats;
+			context_.getSupportedImageFormats(CL_MEM_READ_ONLY, CL_MEM_OBJECT_IMAGE2D, &formats);
+			for (uint32_t i = 0; i != formats.size(); ++i)
+			{
+				if (formats[i].image_channel_order == CL_R && formats[i].image_channel_data_type == CL_UNSIGNED_INT8)
+					return ID_IMAGE;
+			}
+		}
+		return ID_UCHAR;
+	}
+	std::string pitchedBuildOptions() const
+	{
+		std::string options = storagePrecision_ == STORAGE_HALF ? "-DSTORAGE_HALF" : (storagePrecision_ == STORAGE_DOUBLE ? "-DSTORAGE_DOUBLE" : "");
+		if (isDoubleCompute_)
+			options += " -DCOMPUTE_DOUBLE";
+		IdStorage idStorage = pitchedIdStorage();
+		if (idStorage != ID_INT)
+			options += idStorage == ID_IMAGE ? " -DID_IMAGE" : " -DID_UCHAR";
+		size_t maskSize = neighbourMaskSize();
+		if (maskSize != sizeof(float))
+			options += maskSize == sizeof(cl_ushort) ? " -DNEIGHBOUR_MASK=ushort" : " -DNEIGHBOUR_MASK=uchar";
+		return options;
+	}
+	//Prepares fdtdPitchedKernel - Copies the id and boundary grids out to rows padded to CL_DEVICE_MEM_BASE_ADDR_ALIGN. Ids in the edge margin every other path//
+	//leaves alone, and any past the material table, become 0, so the kernel updates whatever it finds without bounds checks//
+	void createPitchedEquation()
+	{
+		state_.pitchedOptions = pitchedBuildOptions();
+		state_.isPitchedReady = false;
+		if (!isMaterialTableExact())
+			return;
+
+		bool isDoubleNeeded = storagePrecision_ == STORAGE_DOUBLE || isDoubleCompute_;
+		if (isDoubleNeeded && device_.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_fp64") == std::string::npos)
+		{
+			std::cout << "Pitched layout unavailable - The device has no cl_khr_fp64 for double precision" << std::endl;
+			state_.isPitchedReady = false;
+			return;
+		}
+
+		cl::Program pitchedProgram;
+		state_.isPitchedReady = createKernelFromFile(pitchedKernelPath_, "fdtdPitchedKernel", state_.pitchedOptions, pitchedProgram, state_.pitchedKernel);
+		if (state_.isPitchedReady)
+			state_.pitchedConnectionsKernel = cl::Kernel(pitchedProgram, "fdtdPitchedConnections", &errorStatus_);
+		state_.isPitchedReady = state_.isPitchedReady && errorStatus_ == CL_SUCCESS;
+		if (!state_.isPitchedReady)
+			return;
+
+		size_t cellSize = storageSize(storagePrecision_);
+		unsigned int alignment = device_.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8 / cellSize;
+		state_.pitch = Cartisian_Grid<float>::alignedPitch(modelWidth_, alignment);
+
+		int radius = state_.materials.stencilRadius();
+		int numMaterials = state_.materials.types().size();
+		Cartisian_Grid<int> ids(modelWidth_, modelHeight_, state_.pitch);
+		Cartisian_Grid<float> boundary(modelWidth_, modelHeight_, state_.pitch);
+		for (int y = 0; y != modelHeight_; ++y)
+		{
+			for (int x = 0; x != modelWidth_; ++x)
+			{
+				int id = idGridInput_[y * modelWidth_ + x];
+				bool isInside = x >= radius && x < modelWidth_ - radius && y >= radius && y < modelHeight_ - radius;
+				ids.valueAt(x, y) = isInside && id > 0 && id < numMaterials ? id : 0;
+				boundary.valueAt(x, y) = boundaryGridInput_[y * modelWidth_ + x];
+			}
+		}
+
+		//With NEIGHBOUR_MASK each updated cell gets a bit per stencil neighbour, set where that neighbour's weight (1 - boundary) is 1, so the kernel//
+		//fetches one mask instead of a float per neighbour. Cells that aren't updated never read theirs. Offsets are (x, y), in the kernel's bit order//
+		static const int neighbourOffsets[12][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 }, { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 }, { 0, -2 }, { 0, 2 }, { -2, 0 }, { 2, 0 } };
+		size_t maskSize = neighbourMaskSize();
+		Cartisian_Grid<cl_ushort> masks(modelWidth_, modelHeight_, state_.pitch);
+		std::vector<cl_uchar> narrowMasks;
+		if (maskSize != sizeof(float))
+		{
+			int numNeighbours = maskSize == sizeof(cl_ushort) ? 12 : 8;
+			for (int y = 0; y != modelHeight_; ++y)
+			{
+				for (int x = 0; x != modelWidth_; ++x)
+				{
+					if (ids.valueAt(x, y) == 0)
+						continue;
+					for (int i = 0; i != numNeighbours; ++i)
+					{
+						if (boundary.valueAt(x + neighbourOffsets[i][0], y + neighbourOffsets[i][1]) == 0.0f)
+							masks.valueAt(x, y) |= 1 << i;
+					}
+				}
+			}
+			if (maskSize == sizeof(cl_uchar))
+				narrowMasks.assign(masks.getGrid(), masks.getGrid() + masks.getSize());
+		}
+		const void* boundaryData = maskSize == sizeof(float) ? (const void*)boundary.getGrid() : (maskSize == sizeof(cl_ushort) ? (const void*)masks.getGrid() : (const void*)narrowMasks.data());
+
+		//Only the pressure levels take the storage precision. Ids go up as ints, or narrowed to 8 bits in a buffer or a CL_R image, per pitchedIdStorage()//
+		IdStorage idStorage = pitchedIdStorage();
+		std::vector<cl_uchar> narrowIds;
+		if (idStorage != ID_INT)
+			narrowIds.assign(ids.getGrid(), ids.getGrid() + ids.getSize());
+		state_.pitchedGridByteSize = (size_t)ids.getSize() * cellSize * 3;
+		state_.pitchedBoundaryGrid = cl::Buffer(context_, CL_MEM_READ_ONLY, ids.getSize() * maskSize);
+		state_.pitchedModelGrid = cl::Buffer(context_, CL_MEM_READ_WRITE, state_.pitchedGridByteSize);
+		if (idStorage == ID_IMAGE)
+		{
+			cl::array<cl::size_type, 3> origin = { 0, 0, 0 };
+			cl::array<cl::size_type, 3> region = { (cl::size_type)modelWidth_, (cl::size_type)modelHeight_, 1 };
+			state_.pitchedIdImage = cl::Image2D(context_, CL_MEM_READ_ONLY, cl::ImageFormat(CL_R, CL_UNSIGNED_INT8), modelWidth_, modelHeight_);
+			commandQueue_.enqueueWriteImage(state_.pitchedIdImage, CL_TRUE, origin, region, state_.pitch, 0, narrowIds.data());
+		}
+		else
+		{
+			size_t idSize = idStorage == ID_UCHAR ? sizeof(cl_uchar) : sizeof(int);
+			state_.pitchedIdGrid = cl::Buffer(context_, CL_MEM_READ_ONLY, ids.getSize() * idSize);
+			commandQueue_.enqueueWriteBuffer(state_.pitchedIdGrid, CL_TRUE, 0, ids.getSize() * idSize, idStorage == ID_UCHAR ? (const void*)narrowIds.data() : (const void*)ids.getGrid());
+		}
+		commandQueue_.enqueueWriteBuffer(state_.pitchedBoundaryGrid, CL_TRUE, 0, ids.getSize() * maskSize, boundaryData);
+		commandQueue_.enqueueFillBuffer(state_.pitchedModelGrid, (cl_uchar)0, 0, state_.pitchedGridByteSize);
+
+		std::vector<int> connections = connectionPairs();
+		std::vector<int> pitchedConnections;
+		for (uint32_t i = 0; i + 1 < connections.size(); i += 2)
+		{
+			pitchedConnections.push_back(pitchedIndex(connections[i] % modelWidth_, connections[i] / modelWidth_));
+			pitchedConnections.push_back(pitchedIndex(connections[i + 1] % modelWidth_, connections[i + 1] / modelWidth_));
+		}
+		state_.numPitchedConnections = pitchedConnections.size();
+		state_.pitchedConnectionsBuffer = cl::Buffer(context_, CL_MEM_READ_ONLY, (pitchedConnections.size() + 1) * sizeof(int));
+		if (state_.numPitchedConnections != 0)
+			commandQueue_.enqueueWriteBuffer(state_.pitchedConnectionsBuffer, CL_TRUE, 0, pitchedConnections.size() * sizeof(int), pitchedConnections.data());
+
+		//A row of work-items per warp, so each reads a run of one aligned row. The global range rounds up to whole groups, the kernel returning past the edge//
+		size_t maxGroupSize = state_.pitchedKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device_);
+		size_t multiple = state_.pitchedKernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(device_);
+		std::vector<size_t> maxItemSizes = device_.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+		size_t localX = std::min(multiple == 0 || multiple > maxGroupSize ? 1 : multiple, maxItemSizes[0]);
+		size_t localY = std::max<size_t>(1, std::min<size_t>({ (size_t)pitchedRowsPerGroup_, maxGroupSize / localX, maxItemSizes[1] }));
+		state_.pitchedLocalws = cl::NDRange(localX, localY);
+		state_.pitchedGlobalws = cl::NDRange((modelWidth_ + localX - 1) / localX * localX, (modelHeight_ + localY - 1) / localY * localY);
+
+		int width = modelWidth_;
+		int height = modelHeight_;
+		int levelSize = ids.getSize();
+		if (idStorage == ID_IMAGE)
+			state_.pitchedKernel.setArg(0, sizeof(cl_mem), &state_.pitchedIdImage);
+		else
+			state_.pitchedKernel.setArg(0, sizeof(cl_mem), &state_.pitchedIdGrid);
+		state_.pitchedKernel.setArg(1, sizeof(cl_mem), &state_.pitchedModelGrid);
+		state_.pitchedKernel.setArg(2, sizeof(cl_mem), &state_.pitchedBoundaryGrid);
+		state_.pitchedKernel.setArg(5, sizeof(cl_mem), &excitationBuffer_);
+		state_.pitchedKernel.setArg(6, sizeof(cl_mem), &outputBuffer_);
+		state_.pitchedKernel.setArg(9, sizeof(cl_mem), &state_.materialTypesBuffer);
+		state_.pitchedKernel.setArg(10, sizeof(cl_mem), &state_.materialCoefficientsBuffer);
+		state_.pitchedKernel.setArg(11, sizeof(int), &width);
+		state_.pitchedKernel.setArg(12, sizeof(int), &height);
+		state_.pitchedKernel.setArg(13, sizeof(int), &state_.pitch);
+		state_.pitchedConnectionsKernel.setArg(0, sizeof(cl_mem), &state_.pitchedModelGrid);
+		state_.pitchedConnectionsKernel.setArg(2, sizeof(int), &levelSize);
+		state_.pitchedConnectionsKernel.setArg(3, sizeof(int), &state_.numPitchedConnections);
+		state_.pitchedConnectionsKernel.setArg(4, sizeof(cl_mem), &state_.pitchedConnectionsBuffer);
+	}
+	//Prepares fdtdBatchedKernel for numVoices_ voices of the current model. Voices start silent, at the model's positions and with its coefficients//
+	void createBatchedEquation()
+	{
+		isBatchedReady_ = false;
+		if (numVoices_ == 0 || model_ == nullptr || !isMaterialTableExact())
+			return;
+		if (!createKernelFromFile(batchedKernelPath_, "fdtdBatchedKernel", "", batchedProgram_, batchedKernel_))
+			return;
+		batchedConnectionsKernel_ = cl::Kernel(batchedProgram_, "fdtdBatchedConnections", &errorStatus_);
+		if (errorStatus_ != CL_SUCCESS)
+			return;
+
+		int numMaterials = state_.materials.types().size();
+		voiceGrids_ = cl::Buffer(context_, CL_MEM_READ_WRITE, (size_t)gridByteSize_ * 3 * numVoices_);
+		commandQueue_.enqueueFillBuffer(voiceGrids_, 0.0f, 0, (size_t)gridByteSize_ * 3 * numVoices_);
+		voiceInputBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, excitation_.numberSamples_ * numVoices_ * sizeof(float));
+		voiceOutputBuffer_ = cl::Buffer(context_, CL_MEM_WRITE_ONLY, output_.numberSamples_ * numVoices_ * sizeof(float));
+		voiceInputPositionsBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, numVoices_ * sizeof(int));
+		voiceOutputPositionsBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, numVoices_ * sizeof(int));
+		voiceCoefficientsBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, numVoices_ * numMaterials * sizeof(Material_Coefficients));
+		voiceMaterials_.assign(numVoices_, state_.materials);
+		voiceInputPositions_.assign(numVoices_, model_->getInputPosition());
+		voiceOutputPositions_.assign(numVoices_, model_->getOutputPosition());
+		uploadVoiceTable();
+		uploadVoicePositions();
+
+		std::vector<int> connections = connectionPairs();
+		numBatchedConnections_ = connections.size();
+		batchedConnectionsBuffer_ = cl::Buffer(context_, CL_MEM_READ_ONLY, (connections.size() + 1) * sizeof(int));
+		if (numBatchedConnections_ != 0)
+			commandQueue_.enqueueWriteBuffer(batchedConnectionsBuffer_, CL_TRUE, 0, connections.size() * sizeof(int), connections.data());
+
+		int radius = state_.materials.stencilRadius();
+		int width = modelWidth_;
+		int height = modelHeight_;
+		int gridSize = gridElements_;
+		batchedKernel_.setArg(0, sizeof(cl_mem), &state_.idGridBuffer);
+		batchedKernel_.setArg(1, sizeof(cl_mem), &voiceGrids_);
+		batchedKernel_.setArg(2, sizeof(cl_mem), &state_.boundaryGridBuffer);
+		batchedKernel_.setArg(5, sizeof(cl_mem), &voiceInputBuffer_);
+		batchedKernel_.setArg(6, sizeof(cl_mem), &voiceOutputBuffer_);
+		batchedKernel_.setArg(7, sizeof(cl_mem), &voiceInputPositionsBuffer_);
+		batchedKernel_.setArg(8, sizeof(cl_mem), &voiceOutputPositionsBuffer_);
+		batchedKernel_.setArg(9, sizeof(cl_mem), &state_.materialTypesBuffer);
+		batchedKernel_.setArg(10, sizeof(cl_mem), &voiceCoefficientsBuffer_);
+		batchedKernel_.setArg(11, sizeof(int), &numMaterials);
+		batchedKernel_.setArg(12, sizeof(int), &radius);
+		batchedKernel_.setArg(13, sizeof(int), &width);
+		batchedKernel_.setArg(14, sizeof(int), &height);
+		batchedConnectionsKernel_.setArg(0, sizeof(cl_mem), &voiceGrids_);
+		batchedConnectionsKernel_.setArg(2, sizeof(int), &gridSize);
+		batchedConnectionsKernel_.setArg(3, sizeof(int), &numBatchedConnections_);
+		batchedConnectionsKernel_.setArg(4, sizeof(cl_mem), &batchedConnectionsBuffer_);
+
+		batchedGlobalws_ = cl::NDRange(modelWidth_, modelHeight_, numVoices_);
+		batchedLocalws_ = cl::NDRange(8, 8, 1);
+		batchedRotationIndex_ = 1;
+		isBatchedReady_ = true;
 	}
 	void createMatrixEquation(const std::string aPath);	//How is the matrix equations defined? Is there just a default matrix equation that can be formed for many equations or need be defined?
 
@@ -463,30 +2203,425 @@ public:
 	{
 
 	}
-	void updateCoefficient(std::string aCoeff, uint32_t aIndex, float aValue)
+	//The unnamed index is the argument index callers used before coefficients bound by name. It is no longer read, and kept so existing calls build//
+	void updateCoefficient(std::string aCoeff, uint32_t, float aValue)
+	{
+		updateCoefficient(aCoeff, aValue);
+	}
+	//Sets coefficient aCoeff of the current model on every path. Names the model's fdtdKernel doesn't take are reported rather than bound to whatever//
+	//argument sits at some index//
+	void updateCoefficient(const std::string& aCoeff, float aValue)
 	{
-		kernel_.setArg(aIndex, sizeof(float), &aValue);	//@ToDo - Need dynamicaly find index for setArg (The first param)
+		if (isHostImplementation())
+			cpuEngine_->updateCoefficient(aCoeff, aValue);
+		else
+		{
+			//The blocked kernel reads folded coefficients from a buffer, uploaded lazily by the next fillBuffer//
+			state_.materials.setCoefficient(aCoeff, aValue);
+			isMaterialTableDirty_ = true;
+
+			//A folded kernel takes its coefficients folded, by the next fillBuffer, and a baked one is built again here with them//
+			std::map<std::string, cl_uint>::const_iterator argument = state_.kernelArguments.find(aCoeff);
+			if (state_.isBakedReady)
+				bakeFoldedCoefficients();
+			else if (state_.isFoldedReady)
+				isFoldedDirty_ = true;
+			else if (argument != state_.kernelArguments.end())
+				state_.kernel.setArg(argument->second, sizeof(float), &aValue);
+			else
+				std::cout << "Coefficient " << aCoeff << " is not an argument of the model's fdtdKernel" << std::endl;
+
+			//Batched voices follow too, until updateVoiceCoefficient() sets one apart//
+			for (uint32_t i = 0; i != voiceMaterials_.size(); ++i)
+				voiceMaterials_[i].setCoefficient(aCoeff, aValue);
+			isVoiceTableDirty_ = !voiceMaterials_.empty();
+		}
+	}
+
+	//Automates aCoeff from the next buffer on, ramping linearly between aBreakpoints, (sample, value) pairs counted from that buffer's first sample,//
+	//and holding the last value after. Only a folded dense kernel, baked or not, is sample accurate, so any other dispatch is refused with false rather//
+	//than moving the value once per buffer. Cleared by createModel()//
+	bool automateCoefficient(const std::string& aCoeff, const std::vector<std::pair<uint64_t, float>>& aBreakpoints)
+	{
+		if (!aBreakpoints.empty() && !beginAutomation(aCoeff))
+			return false;
+
+		std::vector<std::pair<uint64_t, float>> breakpoints = aBreakpoints;
+		for (uint32_t i = 0; i != breakpoints.size(); ++i)
+			breakpoints[i].first += sampleClock_;
+		automation_[aCoeff] = Automation_Stream::ramp(breakpoints);
+		if (automation_[aCoeff].isEmpty())
+			automation_.erase(aCoeff);
+		return true;
+	}
+	//As above from aNumValues values, one per sample from the next buffer's first//
+	bool automateCoefficient(const std::string& aCoeff, const float* aValues, uint32_t aNumValues)
+	{
+		if (aNumValues != 0 && !beginAutomation(aCoeff))
+			return false;
+
+		if (aNumValues == 0)
+			automation_.erase(aCoeff);
+		else
+			automation_[aCoeff] = Automation_Stream::dense(sampleClock_, aValues, aNumValues);
+		return true;
+	}
+	//Stops automating aCoeff, or every coefficient when empty, leaving each where its stream had reached//
+	void clearAutomation(const std::string& aCoeff = "")
+	{
+		for (std::map<std::string, Automation_Stream>::iterator it = automation_.begin(); it != automation_.end();)
+		{
+			if (!aCoeff.empty() && it->first != aCoeff)
+			{
+				++it;
+				continue;
+			}
+			updateCoefficient(it->first, it->second.valueAt(sampleClock_));
+			it = automation_.erase(it);
+		}
+		if (automation_.empty() && implementation_ == Implementation::OPENCL)
+			setFoldedAutomation(false);
+	}
+	//Samples computed since createModel(), the clock automation runs against//
+	uint64_t getSampleClock() const
+	{
+		return sampleClock_;
+	}
+
+	//Runs aNumVoices copies of the current model per launch, sharing its id and boundary grids. fillBuffer() then takes and returns aNumVoices//
+	//interleaved channels, [sample * numVoices + voice]. 0 returns to the single model. OpenCL only - False where batching is unavailable//
+	bool setVoiceCount(uint32_t aNumVoices)
+	{
+		if (implementation_ != Implementation::OPENCL)
+			return aNumVoices == 0;
+
+		numVoices_ = aNumVoices;
+		createBatchedEquation();
+		return numVoices_ == 0 || isBatchedReady_;
+	}
+	uint32_t getVoiceCount() const
+	{
+		return numVoices_;
+	}
+	//Excitation and listener cells of one voice, as (x, y)//
+	void setVoicePositions(uint32_t aVoice, int aInput[2], int aOutput[2])
+	{
+		if (!isBatchedReady_ || aVoice >= numVoices_)
+			return;
+
+		voiceInputPositions_[aVoice] = aInput[1] * modelWidth_ + aInput[0];
+		voiceOutputPositions_[aVoice] = aOutput[1] * modelWidth_ + aOutput[0];
+		uploadVoicePositions();
+	}
+	//As updateCoefficient(), for one voice alone//
+	void updateVoiceCoefficient(uint32_t aVoice, std::string aCoeff, float aValue)
+	{
+		if (!isBatchedReady_ || aVoice >= numVoices_)
+			return;
+
+		voiceMaterials_[aVoice].setCoefficient(aCoeff, aValue);
+		isVoiceTableDirty_ = true;
+	}
+	//Silences one voice, e.g. before it is reused for a new note//
+	void resetVoice(uint32_t aVoice)
+	{
+		if (!isBatchedReady_ || aVoice >= numVoices_)
+			return;
+
+		commandQueue_.enqueueFillBuffer(voiceGrids_, 0.0f, (size_t)gridByteSize_ * 3 * aVoice, (size_t)gridByteSize_ * 3);
+	}
+
+	//Times fdtdKernel with every legal local size for the current model and keeps the fastest, persisting it so createModel() picks it up on later runs.//
+	//Every kernel argument must be set, so call once the coefficients are. The grid is zeroed afterwards. Returns the whole search, empty off OpenCL//
+	std::vector<Work_Group_Timing> tuneWorkGroup()
+	{
+		if (implementation_ != Implementation::OPENCL || model_ == nullptr)
+			return std::vector<Work_Group_Timing>();
+
+		int idxSample = 0;
+		state_.kernel.setArg(1, sizeof(cl_mem), &state_.modelGrid);
+		state_.kernel.setArg(3, sizeof(int), &bufferRotationIndex_);
+		state_.kernel.setArg(4, sizeof(int), &idxSample);
+		std::vector<Work_Group_Timing> sizes = Work_Group_Tuner::search(commandQueue_, device_, state_.kernel, globalws_);
+		localws_ = Work_Group_Tuner::fastest(sizes, localws_);
+		if (std::any_of(sizes.begin(), sizes.end(), [](const Work_Group_Timing& aSize) { return aSize.timePerStep >= 0.0; }))
+			Work_Group_Tuner::store(workGroupKey_, localws_);
+
+		commandQueue_.enqueueFillBuffer(state_.modelGrid, 0.0f, 0, gridByteSize_ * 3);
+		commandQueue_.finish();
+		return sizes;
+	}
+	cl::NDRange getLocalWorkSize() const
+	{
+		return localws_;
+	}
+
+	//Instruction set the host engines run with ("Scalar" for CPU), empty for device backends//
+	std::string getHostArchitecture() const
+	{
+		return cpuEngine_ != nullptr ? cpuEngine_->getArchitecture() : "";
+	}
+
+	//Samples advanced per kernel launch. 1 keeps the per sample fdtdKernel, larger values use fdtdBlockedKernel where the model allows it.//
+	//fdtdBlockedKernel steps the generic material table, with (1-boundary) weighting, rather than the model's own kernel//
+	void setStepsPerLaunch(uint32_t aStepsPerLaunch)
+	{
+		stepsPerLaunch_ = aStepsPerLaunch == 0 ? 1 : aStepsPerLaunch;
+	}
+	uint32_t getStepsPerLaunch() const
+	{
+		return stepsPerLaunch_;
+	}
+	//Runs each fillBuffer as one fdtdPersistentKernel launch, taking precedence over setStepsPerLaunch()//
+	void setPersistentKernel(bool aIsPersistent)
+	{
+		isPersistent_ = aIsPersistent;
+	}
+	//True when an aWidth x aHeight grid's two levels fit in local memory, the small grids the persistent kernel is for. Larger ones still run, with//
+	//one work-group stepping every cell through global memory//
+	bool isPersistentResident(uint32_t aWidth, uint32_t aHeight) const
+	{
+		return implementation_ == Implementation::OPENCL && 2 * (uint64_t)aWidth * aHeight * sizeof(float) <= device_.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+	}
+	//True when fillBuffer() steps a folded dense kernel, the one path automation is sample accurate on//
+	bool isAutomationSampleAccurate() const
+	{
+		return implementation_ == Implementation::OPENCL && state_.isFoldedReady && numVoices_ == 0 && !isPersistent_ && !isSparse_ && !isSplit_ && !isPitched_
+			&& (stepsPerLaunch_ == 1 || !state_.isBlockable);
+	}
+	//"sample_accurate" while automation runs on the folded dense kernel, "per_buffer" when a dispatch switched to since moves it once per buffer//
+	std::string getAutomationLabel() const
+	{
+		return isAutomatedReady_ && isAutomationSampleAccurate() ? "sample_accurate" : "per_buffer";
+	}
+	//True when fillBuffer() is asked to run a path stepping the generic material table rather than the model's own fdtdKernel//
+	bool isGenericDispatch() const
+	{
+		return isPersistent_ || isSparse_ || isSplit_ || isPitched_ || isFolded_ || stepsPerLaunch_ > 1;
+	}
+	//Names the dispatch strategy in use, for labelling benchmark logs. Those stepping the generic material table end in "_generic"//
+	std::string getDispatchLabel() const
+	{
+		std::string label = "steps1";
+		if (isPersistent_)
+			label = "persistent";
+		else if (isSparse_)
+			label = isSparseBucketed_ ? "sparse_bucketed" : "sparse";
+		else if (isSplit_)
+			label = "split";
+		else if (isPitched_)
+		{
+			label = storagePrecision_ == STORAGE_SINGLE && !isDoubleCompute_ ? "pitched" : "pitched_" + getPrecisionLabel();
+			label = idStorage_ == ID_INT ? label : label + "_ids_" + getIdStorageLabel();
+			label = isNeighbourMasked_ ? label + "_masked" : label;
+		}
+		else if (stepsPerLaunch_ > 1)
+			label = "steps" + std::to_string(stepsPerLaunch_);
+		else if (isFolded_)
+			label = "steps1_folded";
+		return isGenericDispatch() ? label + "_generic" : label;
+	}
+	//Launches fdtdSparseKernel over the model's active cells instead of the whole grid. aIsBucketed groups them by material id, so no work-group diverges.//
+	//Takes precedence over setStepsPerLaunch(), below setPersistentKernel()//
+	void setSparseDispatch(bool aIsSparse, bool aIsBucketed = false)
+	{
+		bool isReordered = aIsBucketed != isSparseBucketed_;
+		isSparse_ = aIsSparse;
+		isSparseBucketed_ = aIsBucketed;
+		if (isReordered && state_.isSparseReady && implementation_ == Implementation::OPENCL)
+			uploadActiveCells();
+	}
+	//Runs each material id as its own fdtdMaterialKernel launch plus a coupling pass, rather than one kernel branching per cell on the id.//
+	//Takes precedence over setStepsPerLaunch(), below setPersistentKernel() and setSparseDispatch()//
+	void setSplitDispatch(bool aIsSplit)
+	{
+		isSplit_ = aIsSplit;
+	}
+	//Runs the dense path on a kernel generated from the model's material table, with coefficient arithmetic such as (mu-1.0) and 1.0/(mu+1.0) done once on//
+	//the host rather than per cell per step, from the next createModel(). aIsBaked builds the folded values in as constants, rebuilding in each//
+	//updateCoefficient(), so suits coefficients set once per model. Below every other dispatch//
+	void setCoefficientFolding(bool aIsFolded, bool aIsBaked = false)
+	{
+		isFolded_ = aIsFolded;
+		isBaked_ = aIsBaked;
+	}
+	//"unfolded", "folded" or "baked" for the current model's dense kernel//
+	std::string getFoldingLabel() const
+	{
+		return state_.isBakedReady ? "baked" : (state_.isFoldedReady ? "folded" : "unfolded");
+	}
+	//Runs fdtdPitchedKernel on row padded copies of the grids, with no local size restriction on the grid's dimensions. The copies are separate from the//
+	//grids the other paths and getGrid() share, so choose before createModel(). Takes precedence over setStepsPerLaunch(), below the other dispatches//
+	void setPitchedLayout(bool aIsPitched)
+	{
+		isPitched_ = aIsPitched;
+	}
+	//Storage of the pitched layout's pressure levels, from the next createModel(). Updates compute in float unless aIsDoubleCompute, which like//
+	//STORAGE_DOUBLE needs cl_khr_fp64. Halving the bytes per cell halves the traffic of these bandwidth bound stencils//
+	void setStoragePrecision(StoragePrecision aPrecision, bool aIsDoubleCompute = false)
+	{
+		storagePrecision_ = aPrecision;
+		isDoubleCompute_ = aIsDoubleCompute;
+	}
+	//Replaces the pitched layout's per neighbour boundary weights with one precomputed neighbour mask per cell, uchar or ushort with a plate, from the next//
+	//createModel(). Models whose boundary weights aren't all 0 or 1 keep the weights//
+	void setNeighbourMasks(bool aIsMasked)
+	{
+		isNeighbourMasked_ = aIsMasked;
+	}
+	//Storage of the pitched layout's id grid, from the next createModel(). ID_UCHAR and ID_IMAGE quarter its bytes, the image also reading through the//
+	//texture cache. Devices or models that can't take one fall back to the next wider, see getIdStorageLabel()//
+	void setIdStorage(IdStorage aIdStorage)
+	{
+		idStorage_ = aIdStorage;
+	}
+	//"int32", "uint8" or "image" - The storage the current model's pitched ids were built with when the layout is ready, otherwise the one requested//
+	std::string getIdStorageLabel() const
+	{
+		IdStorage idStorage = idStorage_;
+		if (state_.isPitchedReady)
+			idStorage = state_.pitchedOptions.find("-DID_IMAGE") != std::string::npos ? ID_IMAGE : (state_.pitchedOptions.find("-DID_UCHAR") != std::string::npos ? ID_UCHAR : ID_INT);
+		return idStorage == ID_IMAGE ? "image" : (idStorage == ID_UCHAR ? "uint8" : "int32");
+	}
+	//"fp16", "fp32" or "fp64", with "_fp64_compute" when updates compute in double//
+	std::string getPrecisionLabel() const
+	{
+		std::string label = storagePrecision_ == STORAGE_HALF ? "fp16" : (storagePrecision_ == STORAGE_DOUBLE ? "fp64" : "fp32");
+		return isDoubleCompute_ ? label + "_fp64_compute" : label;
+	}
+	//Whether the pitched layout built for the current model, at the requested precision//
+	bool isPitchedLayoutReady() const
+	{
+		return state_.isPitchedReady;
+	}
+	//The current model's listener over aNumSteps samples of aInput, rendered on the host in double by FDTD_Reference with the current coefficients//
+	//and positions. The yardstick for the storage precisions - OpenCL only, as the host engines keep their own material tables//
+	std::vector<double> renderReference(const float* aInput, uint32_t aNumSteps) const
+	{
+		if (implementation_ != Implementation::OPENCL || model_ == nullptr)
+			return std::vector<double>();
+		return FDTD_Reference::render<double>(idGridInput_, boundaryGridInput_, modelWidth_, modelHeight_, state_.materials, connectionPairs(),
+			model_->getInputPosition(), model_->getOutputPosition(), aInput, aNumSteps);
+	}
+	//Cells fdtdSparseKernel updates for the current model, against gridElements_ for a dense launch//
+	uint32_t getActiveCellCount() const
+	{
+		return state_.activeModelCells.size();
+	}
+	uint32_t getGridCellCount() const
+	{
+		return gridElements_;
 	}
 
 	void setInputPosition(int aInputs[])
 	{
 		model_->setInputPosition(aInputs[0], aInputs[1]);
 		int inPos = model_->getInputPosition();
-		kernel_.setArg(7, sizeof(int), &inPos);
+		if (implementation_ == Implementation::OPENCL)
+		{
+			state_.kernel.setArg(7, sizeof(int), &inPos);
+			if (state_.isBlockable)
+				state_.blockedKernel.setArg(9, sizeof(int), &inPos);
+			if (state_.isPersistentReady)
+				state_.persistentKernel.setArg(8, sizeof(int), &inPos);
+			if (state_.isSparseReady)
+			{
+				state_.sparseKernel.setArg(7, sizeof(int), &inPos);
+				uploadActiveCells();
+			}
+			if (state_.isSplitReady)
+			{
+				state_.couplingKernel.setArg(6, sizeof(int), &inPos);
+				uploadCouplingCells();
+			}
+			if (state_.isPitchedReady)
+			{
+				int pitchedPos = pitchedIndex(aInputs[0], aInputs[1]);
+				state_.pitchedKernel.setArg(7, sizeof(int), &pitchedPos);
+			}
+		}
 	}
 	void setOutputPosition(int aOutputs[])
 	{
 		model_->setOutputPosition(aOutputs[0], aOutputs[1]);
 		int outPos = model_->getOutputPosition();
-		kernel_.setArg(8, sizeof(int), &outPos);
+		if (implementation_ == Implementation::OPENCL)
+		{
+			state_.kernel.setArg(8, sizeof(int), &outPos);
+			if (state_.isBlockable)
+				state_.blockedKernel.setArg(10, sizeof(int), &outPos);
+			if (state_.isPersistentReady)
+				state_.persistentKernel.setArg(9, sizeof(int), &outPos);
+			if (state_.isSparseReady)
+				state_.sparseKernel.setArg(8, sizeof(int), &outPos);
+			if (state_.isSplitReady)
+				state_.couplingKernel.setArg(7, sizeof(int), &outPos);
+			if (state_.isPitchedReady)
+			{
+				int pitchedPos = pitchedIndex(aOutputs[0], aOutputs[1]);
+				state_.pitchedKernel.setArg(8, sizeof(int), &pitchedPos);
+			}
+		}
+	}
+	//Extra excitation and listener taps as (x, y) pairs, beyond setInputPosition()/setOutputPosition(). Kept across createModel(), empty removes them.//
+	//While any are set, fillBuffer() steps one sample per launch so the tap pass can run between steps//
+	void setInputPositions(std::vector<uint32_t> aInputs)
+	{
+		inputTapPositions_ = aInputs;
+		tapInputs_.clear();
+		uploadTaps();
+	}
+	void setOutputPositions(std::vector<uint32_t> aOutputs)
+	{
+		outputTapPositions_ = aOutputs;
+		uploadTaps();
 	}
-	void setInputPositions(std::vector<uint32_t> aInputs);
-	void setOutputPositions(std::vector<uint32_t> aOutputs);
 
-	void setInputs(std::vector<std::vector<float>> aInputs);
+	//Excitation for the next fillBuffer(), one channel per input tap. Channels shorter than the buffer are padded with silence//
+	void setInputs(std::vector<std::vector<float>> aInputs)
+	{
+		uint32_t numInputs = inputTapPositions_.size() / 2;
+		uint32_t numSamples = 0;
+		for (uint32_t i = 0; i != aInputs.size() && i != numInputs; ++i)
+			numSamples = aInputs[i].size() > numSamples ? aInputs[i].size() : numSamples;
 
-	std::vector<std::vector<float>> getInputs();
-	std::vector<std::vector<float>> getOutputs();
+		tapInputs_.assign(numSamples * numInputs, 0.0f);
+		for (uint32_t i = 0; i != aInputs.size() && i != numInputs; ++i)
+		{
+			for (uint32_t j = 0; j != aInputs[i].size(); ++j)
+				tapInputs_[j * numInputs + i] = aInputs[i][j];
+		}
+	}
+
+	//Excitation staged by setInputs() and not yet consumed, per input tap//
+	std::vector<std::vector<float>> getInputs()
+	{
+		uint32_t numInputs = inputTapPositions_.size() / 2;
+		std::vector<std::vector<float>> inputs(numInputs);
+		for (uint32_t i = 0; i != numInputs; ++i)
+		{
+			for (uint32_t j = i; j < tapInputs_.size(); j += numInputs)
+				inputs[i].push_back(tapInputs_[j]);
+		}
+		return inputs;
+	}
+	//The last fillBuffer()'s samples, per output tap//
+	std::vector<std::vector<float>> getOutputs()
+	{
+		uint32_t numOutputs = outputTaps_.size();
+		std::vector<std::vector<float>> outputs(numOutputs, std::vector<float>(numTapOutputSamples_));
+		for (uint32_t i = 0; i != numOutputs; ++i)
+		{
+			for (uint32_t j = 0; j != numTapOutputSamples_; ++j)
+				outputs[i][j] = tapOutputs_[j * numOutputs + i];
+		}
+		return outputs;
+	}
+	//The same samples as read back, interleaved [sample * numOutputTaps + tap], for multichannel audio without a copy//
+	const std::vector<float>& getInterleavedOutputs() const
+	{
+		return tapOutputs_;
+	}
 
 	void initRender()
 	{
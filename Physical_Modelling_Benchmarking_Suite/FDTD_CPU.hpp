@@ -0,0 +1,266 @@
+#ifndef FDTD_CPU_HPP
+#define FDTD_CPU_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FDTD_Grid.hpp"
+#include "FDTD_Materials.hpp"
+#include "Stencil_SIMD.hpp"
+#include "Thread_Pool.hpp"
+
+//Native host implementation of fdtdKernel - Runs the update directly over Model's rotating grids, splitting rows across a thread pool.//
+//Weights neighbours however the model's kernel does, per Material_Table. Sums are folded differently, so outputs differ from the device by rounding//
+class FDTD_CPU
+{
+private:
+	//Below this many cells per chunk the fork-join cost outweighs the extra cores//
+	static const uint32_t minCellsPerChunk_ = 8192;
+
+	//Run of cells in one row sharing a material id, updated by a single Stencil_SIMD call//
+	struct Span
+	{
+		uint32_t offset_;
+		uint32_t count_;
+		int id_;
+	};
+
+	Thread_Pool threadPool_;
+	bool isVectorised_;
+	Material_Table materials_;
+	Model* model_ = nullptr;
+	std::vector<int> idGrid_;
+	std::vector<std::pair<int, int>> connections_;
+	std::vector<int> inputTaps_;
+	std::vector<int> outputTaps_;
+	int margin_ = 1;
+	uint32_t numChunks_ = 1;
+
+	std::vector<Span> spans_;
+	std::vector<uint32_t> rowSpans_;		//Spans of row y are spans_[rowSpans_[y]] to spans_[rowSpans_[y+1]]//
+	std::vector<float> openGrid_;		//(1-boundaryGrid) per cell, or 1 if the kernel doesn't weight, so the vector loops need one multiply per neighbour//
+	std::vector<float> rowAfterOpenGrid_;	//Weights of the y+1 neighbour. openGrid_ shifted down two rows for kernels with a mirrored rightIdx//
+
+	void buildSpans()
+	{
+		const int width = model_->width_;
+		spans_.clear();
+		rowSpans_.assign(model_->height_ + 1, 0);
+		for (uint32_t y = 0; y != model_->height_; ++y)
+		{
+			rowSpans_[y] = spans_.size();
+			if ((int)y < margin_ || (int)y >= (int)model_->height_ - margin_)
+				continue;
+
+			for (int x = margin_; x < width - margin_; ++x)
+			{
+				const int idx = y * width + x;
+				const int id = materials_.type(idGrid_[idx]) == MATERIAL_EMPTY ? 0 : idGrid_[idx];
+				if (x != margin_ && spans_.back().id_ == id)
+					++spans_.back().count_;
+				else
+					spans_.push_back({ (uint32_t)idx, 1, id });
+			}
+		}
+		rowSpans_[model_->height_] = spans_.size();
+	}
+	//Precomputes the weight each cell gets as a neighbour, reproducing how the model's fdtdKernel reads boundaryGrid//
+	void buildOpenGrids()
+	{
+		const float* boundary = model_->getBoundaryGridBuffer();
+		const uint32_t twoRows = 2 * model_->width_;
+		openGrid_.resize(model_->size_);
+		for (uint32_t i = 0; i != model_->size_; ++i)
+			openGrid_[i] = materials_.isBoundaryWeighted() ? 1.0f - boundary[i] : 1.0f;
+
+		rowAfterOpenGrid_ = openGrid_;
+		for (uint32_t i = twoRows; materials_.isRowMirrored() && i < model_->size_; ++i)
+			rowAfterOpenGrid_[i] = openGrid_[i - twoRows];
+	}
+	void stepSpans(uint32_t aRowBegin, uint32_t aRowEnd)
+	{
+		const uint32_t width = model_->width_;
+		const float* grid = model_->getNGridBuffer();
+		const float* previousGrid = model_->getNMinusOneGridBuffer();
+		float* nextGrid = model_->getNPlusOneGridBuffer();
+		const float* openGrid = openGrid_.data();
+		const float* rowAfterOpenGrid = rowAfterOpenGrid_.data();
+		const std::vector<Material_Coefficients>& table = materials_.coefficientTable();
+
+		for (uint32_t i = rowSpans_[aRowBegin]; i != rowSpans_[aRowEnd]; ++i)
+		{
+			const Span& span = spans_[i];
+			switch (materials_.type(span.id_))
+			{
+			case MATERIAL_MEMBRANE:
+				simdMembraneSpan(grid, previousGrid, nextGrid, openGrid, rowAfterOpenGrid, width, span.offset_, span.count_, &table[span.id_]);
+				break;
+			case MATERIAL_STRING:
+				simdStringSpan(grid, previousGrid, nextGrid, openGrid, rowAfterOpenGrid, width, span.offset_, span.count_, &table[span.id_]);
+				break;
+			case MATERIAL_PLATE:
+				simdPlateSpan(grid, previousGrid, nextGrid, openGrid, rowAfterOpenGrid, width, span.offset_, span.count_, &table[span.id_]);
+				break;
+			default:
+				std::fill(nextGrid + span.offset_, nextGrid + span.offset_ + span.count_, 0.0f);
+				break;
+			}
+		}
+	}
+	void stepRows(uint32_t aRowBegin, uint32_t aRowEnd)
+	{
+		const int width = model_->width_;
+		const float* grid = model_->getNGridBuffer();
+		const float* previousGrid = model_->getNMinusOneGridBuffer();
+		float* nextGrid = model_->getNPlusOneGridBuffer();
+		const float* openGrid = openGrid_.data();
+		const float* rowAfterOpenGrid = rowAfterOpenGrid_.data();
+		const std::vector<MaterialType>& types = materials_.types();
+		const std::vector<Material_Coefficients>& table = materials_.coefficientTable();
+
+		for (uint32_t y = aRowBegin; y != aRowEnd; ++y)
+		{
+			for (int x = margin_; x < width - margin_; ++x)
+			{
+				const int idx = y * width + x;
+				const int id = idGrid_[idx];
+				const MaterialType type = id > 0 && id < (int)types.size() ? types[id] : MATERIAL_EMPTY;
+				if (type == MATERIAL_EMPTY)
+				{
+					nextGrid[idx] = 0.0;
+					continue;
+				}
+
+				//Neighbours are weighted by their open flag, the same as the model's fdtdKernel weights them//
+				auto weighted = [&](int aIdx) { return grid[aIdx] * openGrid[aIdx]; };
+
+				const Material_Coefficients& c = table[id];
+				float adjacent = weighted(idx - width) + grid[idx + width] * rowAfterOpenGrid[idx + width];
+				float diagonal = 0.0;
+				float distant = 0.0;
+				if (type != MATERIAL_STRING)
+					adjacent += weighted(idx - 1) + weighted(idx + 1);
+				if (type == MATERIAL_PLATE)
+				{
+					diagonal = weighted(idx - width - 1) + weighted(idx - width + 1) + weighted(idx + width - 1) + weighted(idx + width + 1);
+					distant = weighted(idx - 2 * width) + weighted(idx + 2 * width) + weighted(idx - 2) + weighted(idx + 2);
+				}
+
+				nextGrid[idx] = (2.0f * grid[idx] + c.previous * previousGrid[idx] + c.centre * grid[idx]
+					+ c.adjacent * adjacent + c.diagonal * diagonal + c.distant * distant) * c.normalise;
+			}
+		}
+	}
+	bool isInGrid(int aIdx) const
+	{
+		return aIdx >= 0 && aIdx < (int)model_->size_;
+	}
+public:
+	//aIsVectorised selects the Stencil_SIMD span loops over the scalar per cell update//
+	FDTD_CPU(bool aIsVectorised = false, uint32_t aNumThreads = std::thread::hardware_concurrency()) :
+		threadPool_(aNumThreads == 0 ? 1 : aNumThreads),
+		isVectorised_(aIsVectorised)
+	{
+	}
+
+	//aConnections holds (source, destination) index pairs, as uploaded to the OpenCL connections buffer. Pairs naming a cell off this grid,//
+	//as the buffer's 512 grid indices do on smaller models, are dropped rather than written past it//
+	void createModel(Model* aModel, const int* aIdGrid, const std::string& aKernelSource, const int* aConnections, int aNumConnections)
+	{
+		model_ = aModel;
+		idGrid_.assign(aIdGrid, aIdGrid + model_->size_);
+
+		int maxId = 0;
+		for (uint32_t i = 0; i != idGrid_.size(); ++i)
+			maxId = idGrid_[i] > maxId ? idGrid_[i] : maxId;
+		materials_.parseKernel(aKernelSource, maxId);
+		margin_ = materials_.stencilRadius();
+
+		std::vector<std::pair<int, int>> connections = materials_.connections();
+		if (materials_.usesConnectionBuffer())
+		{
+			for (int i = 0; i + 1 < aNumConnections; i += 2)
+				connections.push_back(std::make_pair(aConnections[i], aConnections[i + 1]));
+		}
+		int gridSize = model_->size_;
+		connections_.clear();
+		for (uint32_t i = 0; i != connections.size(); ++i)
+		{
+			if (connections[i].first >= 0 && connections[i].first < gridSize && connections[i].second >= 0 && connections[i].second < gridSize)
+				connections_.push_back(connections[i]);
+		}
+
+		buildOpenGrids();
+		if (isVectorised_)
+			buildSpans();
+
+		uint32_t chunks = model_->size_ / minCellsPerChunk_;
+		numChunks_ = chunks == 0 ? 1 : (chunks < threadPool_.size() ? chunks : threadPool_.size());
+	}
+	void updateCoefficient(const std::string aCoeff, float aValue)
+	{
+		materials_.setCoefficient(aCoeff, aValue);
+	}
+
+	//Extra excitation and listener cells, beyond the model's own input and output positions//
+	void setTaps(const std::vector<int>& aInputTaps, const std::vector<int>& aOutputTaps)
+	{
+		inputTaps_ = aInputTaps;
+		outputTaps_ = aOutputTaps;
+	}
+
+	//aTapInputs and aTapOutputs, when given, are interleaved [sample * numTaps + tap] for the taps set by setTaps()//
+	void fillBuffer(float* input, float* output, uint32_t numSteps, const float* aTapInputs = nullptr, float* aTapOutputs = nullptr)
+	{
+		const int inputPosition = model_->getInputPosition();
+		const int outputPosition = model_->getOutputPosition();
+		const uint32_t rowBegin = margin_;
+		const uint32_t rowEnd = model_->height_ - margin_;
+
+		for (uint32_t i = 0; i != numSteps; ++i)
+		{
+			output[i] = isInGrid(outputPosition) ? model_->getNGridBuffer()[outputPosition] : 0.0f;
+			for (uint32_t j = 0; aTapOutputs != nullptr && j != outputTaps_.size(); ++j)
+				aTapOutputs[i * outputTaps_.size() + j] = isInGrid(outputTaps_[j]) ? model_->getNGridBuffer()[outputTaps_[j]] : 0.0f;
+
+			if (isVectorised_)
+				threadPool_.parallelFor(rowBegin, rowEnd, numChunks_, [this](uint32_t aBegin, uint32_t aEnd) { stepSpans(aBegin, aEnd); });
+			else
+				threadPool_.parallelFor(rowBegin, rowEnd, numChunks_, [this](uint32_t aBegin, uint32_t aEnd) { stepRows(aBegin, aEnd); });
+
+			//Excitation and coupling are applied after the update, matching the order inside fdtdKernel//
+			float* nextGrid = model_->getNPlusOneGridBuffer();
+			if (isInGrid(inputPosition))
+				nextGrid[inputPosition] += input[i];
+			input[i] = 0.0;
+			for (uint32_t j = 0; aTapInputs != nullptr && j != inputTaps_.size(); ++j)
+			{
+				if (isInGrid(inputTaps_[j]))
+					nextGrid[inputTaps_[j]] += aTapInputs[i * inputTaps_.size() + j];
+			}
+			for (uint32_t j = 0; j != connections_.size(); ++j)
+				nextGrid[connections_[j].second] += model_->getNGridBuffer()[connections_[j].first];
+
+			model_->rotateGrids();
+		}
+	}
+
+	float* getGrid()
+	{
+		return model_->getNGridBuffer();
+	}
+	uint32_t getNumThreads() const
+	{
+		return threadPool_.size();
+	}
+	//Instruction set the span loops run with, for labelling benchmark logs//
+	std::string getArchitecture() const
+	{
+		return isVectorised_ ? simdArchitecture() : "Scalar";
+	}
+};
+
+#endif
@@ -48,7 +48,6 @@ public:
 		grids_ = std::make_tuple((&pressureGrid0_), (&pressureGrid1_), (&pressureGrid2_));
 
 		//Initalise default pressure values//
-		//Later may want to add padding to create grid divisible by x16 on each dimension for memory coalescing//
 		for (int x = 0; x != width_; ++x)
 		{
 			for (int y = 0; y != height_; ++y)
@@ -107,6 +106,17 @@ public:
 		return boundaryGrid_;
 	}
 
+	//Silences the model again, as if freshly constructed, without reallocating its grids//
+	void reset() {
+		for (unsigned int i = 0; i != size_; ++i)
+		{
+			pressureGrid0_.getGrid()[i] = 0.0;
+			pressureGrid1_.getGrid()[i] = 0.0;
+			pressureGrid2_.getGrid()[i] = 0.0;
+		}
+		grids_ = std::make_tuple((&pressureGrid0_), (&pressureGrid1_), (&pressureGrid2_));
+	}
+
 	void rotateGrids() {
 		GridType_* nMinusOne = std::get<0>(grids_);
 		GridType_* n = std::get<1>(grids_);
@@ -0,0 +1,265 @@
+#ifndef FDTD_MATERIALS_HPP
+#define FDTD_MATERIALS_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+//Physics evaluated for a material id in the model's fdtdKernel//
+enum MaterialType { MATERIAL_EMPTY, MATERIAL_MEMBRANE, MATERIAL_STRING, MATERIAL_PLATE };
+
+//Every supported update folds to the same shape:
+//next = (2*u + previous*uM1 + centre*u + adjacent*sum(adjacent) + diagonal*sum(diagonal) + distant*sum(distant)) * normalise
+//Membranes and plates use the 4 adjacent cells, strings only the two along the row axis (y +/- 1)//
+struct Material_Coefficients
+{
+	float previous = 0.0;
+	float centre = 0.0;
+	float adjacent = 0.0;
+	float diagonal = 0.0;
+	float distant = 0.0;
+	float normalise = 0.0;
+};
+
+//Recovers which physics each material id runs from the generated kernel source, and folds the named coefficients passed to updateCoefficient() into Material_Coefficients.//
+//Also records the kernel-wide quirks an engine needs to step exactly what fdtdKernel does - Whether neighbours are weighted by (1-boundaryGrid) at all, and//
+//whether the kernel weights the y+1 neighbour by the y-1 cell's boundary, as the complex models do by defining rightIdx the same as leftIdx.//
+//FDTD_CPU follows both. The table driven OpenCL kernels and FDTD_Reference weight every neighbour by its own boundary, which only differs where a boundary cell holds pressure//
+class Material_Table
+{
+private:
+	struct Material
+	{
+		MaterialType type_ = MATERIAL_EMPTY;
+		bool isFolded_ = false;			//Manual kernels take host precomputed coefficients (muOne, muSquared...) rather than raw ones (mu, lambda...)//
+		std::string muName_ = "mu";		//Complex multi model names the plate stiffness muTwo//
+	};
+
+	std::map<int, Material> materials_;
+	Material defaultMaterial_;			//Kernels using "else {...}" apply one update to every non-zero id//
+	std::map<std::string, float> values_;
+	std::vector<MaterialType> types_;
+	std::vector<Material_Coefficients> coefficients_;
+	std::vector<std::pair<int, int>> connections_;	//(source, destination) pairs hard coded into the kernel//
+	bool usesConnectionBuffer_ = false;
+	bool isBoundaryWeighted_ = true;	//The manual simple single model reads its neighbours unweighted//
+	bool isRowMirrored_ = false;
+	std::vector<int> unhandledIds_;		//Ids with neither a branch nor an else, which fdtdKernel leaves t1x0y0 unset for//
+
+	static std::string stripWhitespace(const std::string& aSource)
+	{
+		std::string stripped;
+		for (size_t i = 0; i != aSource.size(); ++i)
+			if (!isspace((unsigned char)aSource[i]))
+				stripped += aSource[i];
+		return stripped;
+	}
+	static Material classify(const std::string& aExpression)
+	{
+		std::string expression = stripWhitespace(aExpression);
+
+		Material material;
+		if (expression.find("muSquared") != std::string::npos || expression.find("sigma") != std::string::npos)
+		{
+			material.type_ = MATERIAL_PLATE;
+			material.isFolded_ = expression.find("muSquared") != std::string::npos;
+			material.muName_ = expression.find("muTwo") != std::string::npos ? "muTwo" : "mu";
+		}
+		else if (expression.find("stringLambda") != std::string::npos)
+		{
+			material.type_ = MATERIAL_STRING;
+			material.isFolded_ = expression.find("stringLambda*stringLambda") == std::string::npos;
+		}
+		else
+		{
+			material.type_ = MATERIAL_MEMBRANE;
+			material.isFolded_ = expression.find("muOne") != std::string::npos || expression.find("lambdaOne") != std::string::npos;
+		}
+		return material;
+	}
+	float value(const std::string& aName) const
+	{
+		auto it = values_.find(aName);
+		return it == values_.end() ? 0.0f : it->second;
+	}
+	Material_Coefficients fold(const Material& aMaterial) const
+	{
+		Material_Coefficients coefficients;
+		switch (aMaterial.type_)
+		{
+		case MATERIAL_MEMBRANE:
+			if (aMaterial.isFolded_)
+			{
+				coefficients.previous = value("muOne");
+				coefficients.adjacent = value("lambdaOne");
+				coefficients.normalise = value("muTwo");
+			}
+			else
+			{
+				coefficients.previous = value("mu") - 1.0f;
+				coefficients.adjacent = value("lambda");
+				coefficients.normalise = 1.0f / (value("mu") + 1.0f);
+			}
+			coefficients.centre = -4.0f * coefficients.adjacent;
+			break;
+		case MATERIAL_STRING:
+			coefficients.previous = -1.0f;
+			if (aMaterial.isFolded_)
+			{
+				coefficients.adjacent = value("stringLambda");
+				coefficients.normalise = value("stringMu");
+			}
+			else
+			{
+				coefficients.adjacent = value("stringLambda") * value("stringLambda");
+				coefficients.normalise = 1.0f / (value("stringMu") + 1.0f);
+			}
+			coefficients.centre = -2.0f * coefficients.adjacent;
+			break;
+		case MATERIAL_PLATE:
+			if (aMaterial.isFolded_)
+			{
+				coefficients.previous = -value("sigmaMinus");
+				coefficients.distant = -value("muSquared");
+				coefficients.diagonal = -value("muSquaredTwo");
+				coefficients.adjacent = value("muSquaredEight");
+				coefficients.centre = -value("muSquaredTwenty");
+				coefficients.normalise = value("sigmaPlus");
+			}
+			else
+			{
+				float muSquared = value(aMaterial.muName_) * value(aMaterial.muName_);
+				float sigmaDeltaT = value("sigma") * value("deltaT");
+				coefficients.previous = -(1.0f - sigmaDeltaT);
+				coefficients.distant = -muSquared;
+				coefficients.diagonal = -2.0f * muSquared;
+				coefficients.adjacent = 8.0f * muSquared;
+				coefficients.centre = -20.0f * muSquared;
+				coefficients.normalise = 1.0f / (1.0f + sigmaDeltaT);
+			}
+			break;
+		default:
+			break;
+		}
+		return coefficients;
+	}
+	void resolve()
+	{
+		for (size_t id = 1; id < types_.size(); ++id)
+			coefficients_[id] = fold(materialFor(id));
+	}
+	const Material& materialFor(int aId) const
+	{
+		auto it = materials_.find(aId);
+		return it == materials_.end() ? defaultMaterial_ : it->second;
+	}
+public:
+	//Parses the id branches of a generated fdtdKernel. aMaxId is the largest id found in the model's id grid//
+	void parseKernel(const std::string& aSource, int aMaxId)
+	{
+		materials_.clear();
+		defaultMaterial_ = Material();
+		connections_.clear();
+
+		std::smatch match;
+		std::string::const_iterator searchStart = aSource.cbegin();
+		const std::regex branch("if\\s*\\(\\s*idGrid\\[centreIdx\\]\\s*==\\s*(\\d+)\\s*\\)\\s*\\{([^}]*)\\}");
+		while (std::regex_search(searchStart, aSource.cend(), match, branch))
+		{
+			if (std::stoi(match[1]) != 0)
+				materials_[std::stoi(match[1])] = classify(match[2]);
+			searchStart = match.suffix().first;
+		}
+
+		const std::regex defaultBranch("else\\s*\\{([^}]*t1x0y0\\s*=[^}]*)\\}");
+		if (std::regex_search(aSource, match, defaultBranch))
+			defaultMaterial_ = classify(match[1]);
+
+		searchStart = aSource.cbegin();
+		const std::regex connection("if\\s*\\(\\s*centreIdx\\s*==\\s*(\\d+)\\s*\\)\\s*\\{\\s*t1x0y0\\s*\\+=\\s*modelGrid\\[\\s*rotation0\\s*\\+\\s*(\\d+)\\s*\\]");
+		while (std::regex_search(searchStart, aSource.cend(), match, connection))
+		{
+			connections_.push_back(std::make_pair(std::stoi(match[2]), std::stoi(match[1])));
+			searchStart = match.suffix().first;
+		}
+		usesConnectionBuffer_ = aSource.find("connections[") != std::string::npos;
+
+		const std::string stripped = stripWhitespace(aSource);
+		isBoundaryWeighted_ = stripped.find("(1-boundaryGrid[") != std::string::npos;
+		std::smatch leftIndex;
+		std::smatch rightIndex;
+		isRowMirrored_ = std::regex_search(stripped, leftIndex, std::regex("intleftIdx=([^;]*);")) && std::regex_search(stripped, rightIndex, std::regex("intrightIdx=([^;]*);"))
+			&& leftIndex[1] == rightIndex[1];
+
+		types_.assign(aMaxId + 1, MATERIAL_EMPTY);
+		coefficients_.assign(aMaxId + 1, Material_Coefficients());
+		unhandledIds_.clear();
+		for (int id = 1; id <= aMaxId; ++id)
+		{
+			types_[id] = materialFor(id).type_;
+			if (types_[id] == MATERIAL_EMPTY && materials_.find(id) == materials_.end())
+				unhandledIds_.push_back(id);
+		}
+		resolve();
+
+		//Nothing defines what these cells hold on the device, so the table engines zero them like id 0//
+		for (size_t i = 0; i != unhandledIds_.size(); ++i)
+			std::cout << "Material id " << unhandledIds_[i] << " has no branch in fdtdKernel - Stepped as empty" << std::endl;
+	}
+	void setCoefficient(const std::string& aName, float aValue)
+	{
+		values_[aName] = aValue;
+		resolve();
+	}
+
+	MaterialType type(int aId) const
+	{
+		return aId > 0 && aId < (int)types_.size() ? types_[aId] : MATERIAL_EMPTY;
+	}
+	const Material_Coefficients& coefficients(int aId) const
+	{
+		return coefficients_[aId];
+	}
+	const std::vector<MaterialType>& types() const
+	{
+		return types_;
+	}
+	const std::vector<Material_Coefficients>& coefficientTable() const
+	{
+		return coefficients_;
+	}
+	const std::vector<std::pair<int, int>>& connections() const
+	{
+		return connections_;
+	}
+	bool usesConnectionBuffer() const
+	{
+		return usesConnectionBuffer_;
+	}
+	bool isBoundaryWeighted() const
+	{
+		return isBoundaryWeighted_;
+	}
+	//True when the y+1 neighbour is weighted by (1-boundaryGrid) of the y-1 cell rather than its own//
+	bool isRowMirrored() const
+	{
+		return isRowMirrored_;
+	}
+	const std::vector<int>& unhandledIds() const
+	{
+		return unhandledIds_;
+	}
+	//Cells closer than this to the grid edge are never updated//
+	int stencilRadius() const
+	{
+		return std::find(types_.begin(), types_.end(), MATERIAL_PLATE) != types_.end() ? 2 : 1;
+	}
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef FDTD_REFERENCE_HPP
+#define FDTD_REFERENCE_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "FDTD_Materials.hpp"
+
+//Plain scalar render of a model in any precision, with no device, threads or vector units involved. Follows the order every engine steps in - Listener read,//
+//update of the cells past the stencil margin, then excitation and connections - so render<double>() is what reduced precision storage is measured against//
+class FDTD_Reference
+{
+public:
+	//aConnections holds (source, destination) pairs. Coefficients are Material_Table's folded floats, widened to T//
+	template<typename T>
+	static std::vector<T> render(const int* aIdGrid, const float* aBoundaryGrid, int aWidth, int aHeight, const Material_Table& aMaterials, const std::vector<int>& aConnections,
+		int aInputPosition, int aOutputPosition, const float* aInput, uint32_t aNumSteps)
+	{
+		const int gridSize = aWidth * aHeight;
+		const int radius = aMaterials.stencilRadius();
+		const int w = aWidth;
+		std::vector<T> levels((size_t)gridSize * 3, T(0));
+		T* previous = levels.data();
+		T* current = previous + gridSize;
+		T* next = current + gridSize;
+
+		std::vector<T> output(aNumSteps);
+		for (uint32_t i = 0; i != aNumSteps; ++i)
+		{
+			output[i] = aOutputPosition >= 0 && aOutputPosition < gridSize ? current[aOutputPosition] : T(0);
+			for (int y = radius; y < aHeight - radius; ++y)
+			{
+				for (int x = radius; x < aWidth - radius; ++x)
+				{
+					const int idx = y * w + x;
+					const MaterialType type = aMaterials.type(aIdGrid[idx]);
+					if (type == MATERIAL_EMPTY)
+					{
+						next[idx] = T(0);
+						continue;
+					}
+
+					auto weighted = [&](int aIdx) { return current[aIdx] * (T(1) - T(aBoundaryGrid[aIdx])); };
+					const Material_Coefficients& c = aMaterials.coefficientTable()[aIdGrid[idx]];
+					T adjacent = weighted(idx - w) + weighted(idx + w);
+					T diagonal = T(0);
+					T distant = T(0);
+					if (type != MATERIAL_STRING)
+						adjacent += weighted(idx - 1) + weighted(idx + 1);
+					if (type == MATERIAL_PLATE)
+					{
+						diagonal = weighted(idx - w - 1) + weighted(idx - w + 1) + weighted(idx + w - 1) + weighted(idx + w + 1);
+						distant = weighted(idx - 2 * w) + weighted(idx + 2 * w) + weighted(idx - 2) + weighted(idx + 2);
+					}
+
+					next[idx] = (T(2) * current[idx] + T(c.previous) * previous[idx] + T(c.centre) * current[idx]
+						+ T(c.adjacent) * adjacent + T(c.diagonal) * diagonal + T(c.distant) * distant) * T(c.normalise);
+				}
+			}
+
+			if (aInputPosition >= 0 && aInputPosition < gridSize)
+				next[aInputPosition] += T(aInput[i]);
+			for (uint32_t j = 0; j + 1 < aConnections.size(); j += 2)
+				next[aConnections[j + 1]] += current[aConnections[j]];
+
+			T* oldPrevious = previous;
+			previous = current;
+			current = next;
+			next = oldPrevious;
+		}
+		return output;
+	}
+};
+
+#endif
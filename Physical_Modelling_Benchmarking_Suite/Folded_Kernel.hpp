@@ -0,0 +1,187 @@
+#ifndef FOLDED_KERNEL_HPP
+#define FOLDED_KERNEL_HPP
+
+#include <stdint.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FDTD_Materials.hpp"
+
+//Generates an fdtdKernel with the coefficient arithmetic of a model's generated kernel, (mu-1.0), 1.0/(mu+1.0) and the like, hoisted out to the host.//
+//Material_Table folds the named coefficients, and each material id's branch reads its folded set either from a __constant Folded_Coefficients struct,//
+//laid out as values(), passed as the coefficientsArgument, or as compile time constants from bakedOptions(). The first 11 arguments match the generated//
+//kernels', connections included. An automated source instead takes a __global table of structs, one per sample of the buffer, as the automationArgument//
+class Folded_Kernel
+{
+private:
+	typedef std::pair<const char*, float Material_Coefficients::*> Field;
+
+	//Folded coefficients a material type's update reads, in argument order//
+	static std::vector<Field> fields(MaterialType aType)
+	{
+		std::vector<Field> fields = { { "previous", &Material_Coefficients::previous }, { "centre", &Material_Coefficients::centre },
+			{ "adjacent", &Material_Coefficients::adjacent } };
+		if (aType == MATERIAL_PLATE)
+		{
+			fields.push_back({ "diagonal", &Material_Coefficients::diagonal });
+			fields.push_back({ "distant", &Material_Coefficients::distant });
+		}
+		fields.push_back({ "normalise", &Material_Coefficients::normalise });
+		return fields;
+	}
+	static std::string name(int aId, const char* aField)
+	{
+		return "c" + std::to_string(aId) + "_" + aField;
+	}
+	//A coefficient as the kernel body reads it - The -D name when baked, otherwise the struct member//
+	static std::string read(int aId, const char* aField, bool aIsBaked)
+	{
+		return aIsBaked ? name(aId, aField) : "coefficients->" + name(aId, aField);
+	}
+	//Exact OpenCL C literal for aValue - Hex floats round trip every bit//
+	static std::string literal(float aValue)
+	{
+		if (std::isnan(aValue))
+			return "NAN";
+		if (std::isinf(aValue))
+			return aValue < 0.0f ? "(-INFINITY)" : "INFINITY";
+
+		char text[32];
+		snprintf(text, sizeof(text), "(%af)", aValue);
+		return text;
+	}
+	static std::string weighted(const std::string& aOffset)
+	{
+		return "weighted(current, boundaryGrid, centreIdx" + aOffset + ")";
+	}
+	//Folded update for material aId, the same sums in the same order as materialUpdate() in the repo's kernels//
+	static std::string update(int aId, MaterialType aType, bool aIsBaked)
+	{
+		std::string adjacent = weighted(" - w") + " + " + weighted(" + w");
+		if (aType != MATERIAL_STRING)
+			adjacent = "(" + adjacent + ") + (" + weighted(" - 1") + " + " + weighted(" + 1") + ")";
+
+		std::string expression = "2.0f * t0x0y0 + " + read(aId, "previous", aIsBaked) + " * previous[centreIdx] + " + read(aId, "centre", aIsBaked) + " * t0x0y0 + "
+			+ read(aId, "adjacent", aIsBaked) + " * (" + adjacent + ")";
+		if (aType == MATERIAL_PLATE)
+		{
+			expression += " + " + read(aId, "diagonal", aIsBaked) + " * (" + weighted(" - w - 1") + " + " + weighted(" - w + 1") + " + " + weighted(" + w - 1") + " + " + weighted(" + w + 1") + ")";
+			expression += " + " + read(aId, "distant", aIsBaked) + " * (" + weighted(" - 2 * w") + " + " + weighted(" + 2 * w") + " + " + weighted(" - 2") + " + " + weighted(" + 2") + ")";
+		}
+		return "(" + expression + ") * " + read(aId, "normalise", aIsBaked);
+	}
+public:
+	//Name of the __constant Folded_Coefficients* argument of an unbaked source with any materials//
+	static constexpr const char* coefficientsArgument = "coefficients";
+	//Name of the __global Folded_Coefficients* argument of an automated source, indexed by idxSample//
+	static constexpr const char* automationArgument = "automation";
+
+	static std::string source(const Material_Table& aMaterials, bool aIsBaked, bool aIsAutomated = false)
+	{
+		const std::vector<MaterialType>& types = aMaterials.types();
+		int radius = aMaterials.stencilRadius();
+
+		std::string members;
+		std::string branches;
+		for (uint32_t id = 1; id < types.size(); ++id)
+		{
+			if (types[id] == MATERIAL_EMPTY)
+				continue;
+
+			std::vector<Field> idFields = fields(types[id]);
+			for (uint32_t i = 0; i != idFields.size(); ++i)
+				members += "\tfloat " + name(id, idFields[i].first) + ";\n";
+			branches += std::string(branches.empty() ? "\t\tif" : "\t\telse if") + " (id == " + std::to_string(id) + ")\n\t\t\tt1x0y0 = " + update(id, types[id], aIsBaked) + ";\n";
+		}
+		bool isStruct = !aIsBaked && !members.empty();
+		std::string declarations = isStruct ? "typedef struct\n{\n" + members + "} Folded_Coefficients;\n\n" : "";
+		bool isAutomated = isStruct && aIsAutomated;
+		std::string parameters = isStruct ? std::string(isAutomated ? ", __global const Folded_Coefficients* " : ", __constant Folded_Coefficients* ") + (isAutomated ? automationArgument : coefficientsArgument) : "";
+		std::string automation = isAutomated ? std::string("\t\t__global const Folded_Coefficients* ") + coefficientsArgument + " = " + automationArgument + " + idxSample;\n" : "";
+
+		std::string connections;
+		const std::vector<std::pair<int, int>>& pairs = aMaterials.connections();
+		for (uint32_t i = 0; i != pairs.size(); ++i)
+			connections += "\tif (centreIdx == " + std::to_string(pairs[i].second) + ")\n\t\tt1x0y0 += current[" + std::to_string(pairs[i].first) + "];\n";
+		if (aMaterials.usesConnectionBuffer())
+			connections += "\tfor (int i = 0; i + 1 < numConnections; i += 2)\n\t{\n\t\tif (centreIdx == connections[i + 1])\n\t\t\tt1x0y0 += current[connections[i]];\n\t}\n";
+
+		std::string bounds = std::to_string(radius);
+		return
+			"int rem(int x, int y)\n"
+			"{\n"
+			"\treturn (x % y + y) % y;\n"
+			"}\n"
+			"\n"
+			"float weighted(__global float* current, __global float* boundaryGrid, int idx)\n"
+			"{\n"
+			"\treturn current[idx] * (1 - boundaryGrid[idx]);\n"
+			"}\n"
+			"\n"
+			+ declarations +
+			"//Generated by Folded_Kernel - Coefficients arrive folded per material id" + std::string(aIsBaked ? ", as build options" : "") + "//\n"
+			"__kernel\n"
+			"void fdtdKernel(__global int* idGrid, __global float* modelGrid, __global float* boundaryGrid, int idxRotate, int idxSample, __global float* input, __global float* output, "
+			"int inputPosition, int outputPosition, int numConnections, __global int* connections" + parameters + ")\n"
+			"{\n"
+			"\tint x = get_global_id(0);\n"
+			"\tint y = get_global_id(1);\n"
+			"\tint width = get_global_size(0);\n"
+			"\tint height = get_global_size(1);\n"
+			"\tint gridSize = width * height;\n"
+			"\t__global float* current = modelGrid + gridSize * rem(idxRotate, 3);\n"
+			"\t__global float* previous = modelGrid + gridSize * rem(idxRotate - 1, 3);\n"
+			"\t__global float* next = modelGrid + gridSize * rem(idxRotate + 1, 3);\n"
+			"\n"
+			"\tint w = width;\n"
+			"\tint centreIdx = y * width + x;\n"
+			"\tif (centreIdx == outputPosition)\n"
+			"\t\toutput[idxSample] = current[centreIdx];\n"
+			"\n"
+			"\tfloat t1x0y0 = 0.0f;\n"
+			"\tif (x >= " + bounds + " && x < width - " + bounds + " && y >= " + bounds + " && y < height - " + bounds + ")\n"
+			"\t{\n"
+			"\t\tfloat t0x0y0 = current[centreIdx];\n"
+			"\t\tint id = idGrid[centreIdx];\n"
+			+ automation + branches +
+			"\t}\n"
+			"\n"
+			"\tif (centreIdx == inputPosition)\n"
+			"\t\tt1x0y0 += input[idxSample];\n"
+			+ connections +
+			"\n"
+			"\tnext[centreIdx] = t1x0y0;\n"
+			"}\n";
+	}
+	//Folded coefficients in Folded_Coefficients' layout, all floats so the struct has no padding//
+	static std::vector<float> values(const Material_Table& aMaterials)
+	{
+		std::vector<float> values;
+		const std::vector<MaterialType>& types = aMaterials.types();
+		for (uint32_t id = 1; id < types.size(); ++id)
+		{
+			std::vector<Field> idFields = fields(types[id]);
+			for (uint32_t i = 0; i != idFields.size() && types[id] != MATERIAL_EMPTY; ++i)
+				values.push_back(aMaterials.coefficients(id).*idFields[i].second);
+		}
+		return values;
+	}
+	//-D definitions standing in for the struct of a baked source. Each new set of values is a new build, so bake coefficients that stay put//
+	static std::string bakedOptions(const Material_Table& aMaterials)
+	{
+		std::string options;
+		const std::vector<MaterialType>& types = aMaterials.types();
+		for (uint32_t id = 1; id < types.size(); ++id)
+		{
+			std::vector<Field> idFields = fields(types[id]);
+			for (uint32_t i = 0; i != idFields.size() && types[id] != MATERIAL_EMPTY; ++i)
+				options += (options.empty() ? "-D" : " -D") + name(id, idFields[i].first) + "=" + literal(aMaterials.coefficients(id).*idFields[i].second);
+		}
+		return options;
+	}
+};
+
+#endif
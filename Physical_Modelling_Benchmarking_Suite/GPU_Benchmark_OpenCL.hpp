@@ -9,17 +9,22 @@
 //#include <CL/cl.hpp>
 #include <CL/cl_gl.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <random>
 
 #include "OpenCL_Wrapper.h"
 #include "Benchmarker.hpp"
 #include "FDTD_Accelerated.hpp"
+#include "Audio_Stream.hpp"
 #include "AudioFile.h"
 
 class GPU_Benchmark_OpenCL
@@ -39,7 +44,11 @@ private:
 	float* outputBuffer_;
 
 	OpenCL_Wrapper openCL;
+	Implementation implementation_;
 	std::string deviceName_;
+	std::string engineTag_;		//Log file tag, so each engine's CSVs sit next to each other in CL_Logs//
+	std::vector<uint32_t> stepsPerLaunchSweep_;	//Temporal blocking depths the realtime tests are repeated for//
+	std::map<std::string, std::map<uint64_t, uint32_t>> maxRealtimeDimensions_;	//Largest grid dimension without a deadline miss, per test and buffer length//
 	uint32_t currentPlatformIdx_;
 	uint32_t currentDeviceIdx_;
 	cl::NDRange globalWorkspace_;
@@ -63,7 +72,8 @@ private:
 		bufferLength_ = aBufferLength;
 		bufferSize_ = bufferLength_ * sizeof(datatype);
 
-		setLocalWorkspace(bufferLength_);
+		if (implementation_ == Implementation::OPENCL)
+			setLocalWorkspace(bufferLength_);
 	}
 	void setWorkspaceSize(uint32_t aGlobalSize, uint32_t aLocalSize)
 	{
@@ -90,9 +100,118 @@ private:
 		bufferSize_ = aBufferSize;
 		bufferLength_ = bufferSize_ / sizeof(datatype);
 
-		setLocalWorkspace(bufferLength_);
+		if (implementation_ == Implementation::OPENCL)
+			setLocalWorkspace(bufferLength_);
 	}
 
+	//Time one buffer lasts when played, in ms//
+	static double bufferDeadline(uint64_t aBufferLength, size_t aSampleRate)
+	{
+		return 1000.0 * (double)aBufferLength / (double)aSampleRate;
+	}
+	//Per buffer write/kernel/read times and per launch queued->submit->start->end times, for the Write_Time ... Launch_Run fields. The profile sums//
+	//sampled launches and buffers only, so the per buffer kernel time scales the sampled total up to every launch of the run before dividing//
+	void recordLaunchProfile(const std::string aTimer)
+	{
+		const Launch_Profile& profile = fdtdSynth.getLaunchProfile();
+		double numBuffers = profile.numBuffers != 0 ? profile.numBuffers : 1;
+		double numProfiled = profile.numProfiled != 0 ? profile.numProfiled : 1;
+		double numProfiledBuffers = profile.numProfiledBuffers != 0 ? profile.numProfiledBuffers : 1;
+		clBenchmarker_.recordMetric(aTimer, "Write_Time", profile.writeTime / numProfiledBuffers);
+		clBenchmarker_.recordMetric(aTimer, "Kernel_Time", profile.kernelTime * (profile.numLaunches / numProfiled) / numBuffers);
+		clBenchmarker_.recordMetric(aTimer, "Read_Time", profile.readTime / numProfiledBuffers);
+		clBenchmarker_.recordMetric(aTimer, "Launch_Queued", profile.queuedToSubmit / numProfiled);
+		clBenchmarker_.recordMetric(aTimer, "Launch_Submit", profile.submitToStart / numProfiled);
+		clBenchmarker_.recordMetric(aTimer, "Launch_Run", profile.kernelTime / numProfiled);
+	}
+	//Call before elapsedTimer() resets the deadline counts. Only extends an unbroken run of passing dimensions from minDimensionSize_,//
+	//so a larger grid that squeaks through after a smaller one failed isn't reported as safe//
+	void recordRealtimeDimension(const std::string aTest, uint64_t aBufferLength, uint32_t aDimension, const std::string aTimer)
+	{
+		uint32_t& maxDimension = maxRealtimeDimensions_[aTest + fdtdSynth.getDispatchLabel()][aBufferLength];
+		bool isUnbroken = aDimension == minDimensionSize_ || maxDimension == aDimension / 2;
+		if (isUnbroken && clBenchmarker_.getDeadlineMisses(aTimer) == 0)
+			maxDimension = aDimension;
+	}
+	//Every dispatch but the per sample one runs the generic material table kernel whatever the model's own kernel is, so a manual model would time the//
+	//same code as its auto twin, under different physics. The manual tests only run where each model keeps its own fdtdKernel//
+	bool isManualTimed() const
+	{
+		return !fdtdSynth.isGenericDispatch();
+	}
+	//Writes the max real-time grid size per buffer length, once a test has run every dimension. 0 when even the smallest grid missed//
+	void logMaxRealtimeGridSize(const std::string aTest, size_t aFrameRate)
+	{
+		std::string key = aTest + fdtdSynth.getDispatchLabel();
+		std::string strSummaryFileName = "CL_Logs/";
+		strSummaryFileName.append(deviceName_);
+		strSummaryFileName.append(engineTag_);
+		strSummaryFileName.append("_");
+		strSummaryFileName.append(aTest);
+		strSummaryFileName.append("_max_realtime_grid");
+		strSummaryFileName.append(std::to_string(aFrameRate));
+		strSummaryFileName.append(fdtdSynth.getDispatchLabel());
+		strSummaryFileName.append(".csv");
+		CSV_Logger summaryLogger(strSummaryFileName, { "Buffer_Size", "Deadline", "Max_Dimension", "Max_Cells" });
+
+		std::cout << "Max real-time grid size for " << key << std::endl;
+		const std::map<uint64_t, uint32_t>& dimensions = maxRealtimeDimensions_[key];
+		for (auto it = dimensions.begin(); it != dimensions.end(); ++it)
+		{
+			uint64_t numCells = (uint64_t)it->second * it->second;
+			std::cout << "Buffer size " << it->first << ": " << it->second << "x" << it->second << std::endl;
+			summaryLogger.addRecord({ std::to_string(it->first), std::to_string(bufferDeadline(it->first, aFrameRate)), std::to_string(it->second), std::to_string(numCells) });
+		}
+		std::cout << std::endl;
+		maxRealtimeDimensions_.erase(key);
+	}
+	struct Auto_Test_Model
+	{
+		std::string path;
+		std::vector<std::pair<std::string, std::pair<uint32_t, float>>> coefficients;	//Name, kernel argument index and value, as the realtime tests set them//
+	};
+	//Columns of every per buffer size real-time log - The timings, deadline misses, then device transfer and launch times//
+	static const std::vector<std::string>& realtimeFields()
+	{
+		static const std::vector<std::string> fields = { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference",
+			"Deadline_Misses", "Miss_Fraction", "Worst_Slack", "Write_Time", "Kernel_Time", "Read_Time", "Launch_Queued", "Launch_Submit", "Launch_Run" };
+		return fields;
+	}
+	//The auto generated models the dispatch comparison and work group tuning run over, each completed with a dimension and ".json"//
+	static const std::vector<Auto_Test_Model>& autoTestModels()
+	{
+		static const std::vector<Auto_Test_Model> models = {
+			{ "resources/kernels/auto/simple_single_model/simpleSingleModelTestAuto", { { "lambda", { 10, 0.0018f } }, { "mu", { 9, 0.000005f } } } },
+			{ "resources/kernels/auto/simple_multi_model/simpleMultiModelTestAuto", { { "stringLambda", { 10, 0.18f } }, { "stringMu", { 9, 0.0005f } } } },
+			{ "resources/kernels/auto/complex_multi_model/complexMultiModelTestAuto", { { "lambda", { 11, 0.018f } }, { "mu", { 12, 0.000005f } }, { "stringMu", { 13, 0.001f } },
+				{ "stringLambda", { 14, 0.1f } }, { "deltaT", { 15, 1.0f / 44100.0f } }, { "muTwo", { 16, 0.1f } }, { "sigma", { 17, 50.01f } } } }
+		};
+		return models;
+	}
+	//The hand written models, with the host folded coefficients their realtime tests set//
+	static const std::vector<Auto_Test_Model>& manualTestModels()
+	{
+		static const std::vector<Auto_Test_Model> models = {
+			{ "resources/kernels/manual/simple_single_model/simpleSingleModelTestManual", { { "muOne", { 9, 0.000005f - 1.0f } }, { "muTwo", { 10, 1.0f / 1.000005f } }, { "lambdaOne", { 11, 0.0018f } } } },
+			{ "resources/kernels/manual/simple_multi_model/simpleMultiModelTestManual", { { "stringLambda", { 10, 0.18f * 0.18f } }, { "stringMu", { 9, 1.0f / 1.0005f } } } },
+			{ "resources/kernels/manual/complex_multi_model/complexMultiModelTestManual", { { "lambda", { 11, 0.018f } }, { "mu", { 12, 0.000005f } }, { "stringMu", { 13, 0.001f } },
+				{ "stringLambda", { 14, 0.1f } }, { "deltaT", { 15, 1.0f / 44100.0f } }, { "muTwo", { 16, 0.1f } }, { "sigma", { 17, 50.01f } } } }
+		};
+		return models;
+	}
+	static const uint64_t comparisonBufferLength_ = 512;
+	//One run of runComparison - Each variant is set up before the model is created and prepared after its coefficients are set//
+	struct Comparison
+	{
+		std::string label;																		//Log name after the device and engine//
+		std::vector<std::string> metrics;														//Columns after the timing ones//
+		std::vector<Auto_Test_Model> models;
+		uint32_t numVariants = 0;
+		std::function<FDTD_Accelerated&(uint32_t aVariant)> setup;								//Returns the engine the variant runs on//
+		std::function<std::string(FDTD_Accelerated&, const Auto_Test_Model&, uint32_t aVariant)> prepare;	//Returns the variant's label, or "" to skip it//
+		std::function<void(FDTD_Accelerated&, const Auto_Test_Model&, uint32_t aVariant, uint64_t aSample)> fill;	//Optional, replaces fillBuffer//
+		std::function<std::vector<double>(FDTD_Accelerated&)> reference;						//Optional, errors are against it instead of the baseline//
+	};
 	void impulse(uint32_t aLength, uint32_t aImpulseLength, float* aInput)
 	{
 		for (uint32_t i = 0; i != aLength; ++i)
@@ -129,13 +248,14 @@ private:
 		{
 			fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, 1);
 		}
+		Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer("singleModelTestAuto");
 		for (uint32_t i = 0; i != aN; ++i)
 		{
-			clBenchmarker_.startTimer("singleModelTestAuto");
+			clBenchmarker_.startTimer(timer);
 
 			fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, bufferLength_);
 
-			clBenchmarker_.pauseTimer("singleModelTestAuto");
+			clBenchmarker_.pauseTimer(timer);
 		}
 		clBenchmarker_.elapsedTimer("singleModelTestAuto");
 
@@ -190,8 +310,10 @@ private:
 			std::string strBenchmarkFileNameAuto = "CL_Logs/";
 			strBenchmarkFileNameAuto.append(deviceName_);
 			std::string strBenchmarkFileNameManual = strBenchmarkFileNameAuto;
-			strBenchmarkFileNameAuto.append("_cl_single_model_test_auto");
-			strBenchmarkFileNameManual.append("_cl_single_model_test_manual");
+			strBenchmarkFileNameAuto.append(engineTag_);
+			strBenchmarkFileNameAuto.append("_single_model_test_auto");
+			strBenchmarkFileNameManual.append(engineTag_);
+			strBenchmarkFileNameManual.append("_single_model_test_manual");
 			std::string strFrameRate = std::to_string(aFrameRate);
 			strBenchmarkFileNameAuto.append(strFrameRate);
 			strBenchmarkFileNameManual.append(strFrameRate);
@@ -199,9 +321,11 @@ private:
 			strBenchmarkFileNameManual.append("dimensions");
 			strBenchmarkFileNameAuto.append(std::to_string(n));
 			strBenchmarkFileNameManual.append(std::to_string(n));
+			strBenchmarkFileNameAuto.append(fdtdSynth.getDispatchLabel());
+			strBenchmarkFileNameManual.append(fdtdSynth.getDispatchLabel());
 			strBenchmarkFileNameAuto.append(".csv");
 			strBenchmarkFileNameManual.append(".csv");
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, realtimeFields());
 
 			// AUTO
 			uint64_t numSamplesComputed = 0;
@@ -236,11 +360,14 @@ private:
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
 				impulse(currentBufferLength, 5, inputBuffer_);
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -248,6 +375,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("single_model_test_auto", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -261,8 +390,11 @@ private:
 				numSamplesComputed = 0;
 			}
 
+			if (!isManualTimed())
+				continue;
+
 			// MANUAL
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, realtimeFields());
 			for (size_t i = 0; i != bufferSizesLength; ++i)
 			{
 				uint64_t currentBufferLength = bufferSizes[i];
@@ -298,11 +430,14 @@ private:
 				{
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -310,6 +445,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("single_model_test_manual", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -323,6 +460,104 @@ private:
 				numSamplesComputed = 0;
 			}
 		}
+		logMaxRealtimeGridSize("single_model_test_auto", aFrameRate);
+		if (isManualTimed())
+			logMaxRealtimeGridSize("single_model_test_manual", aFrameRate);
+	}
+	//Streams the simple single model through submitBuffer()/collectBuffer(), keeping one buffer submitted ahead of the one being collected//
+	void runSimpleSingleModelTestAsync(size_t aFrameRate, bool isWarmup)
+	{
+		for (uint32_t n = minDimensionSize_; n <= maxDimensionSize_; n *= 2)
+		{
+			std::string modelPathAuto = "resources/kernels/auto/simple_single_model/simpleSingleModelTestAuto";
+			modelPathAuto.append(std::to_string(n));
+			modelPathAuto.append(".json");
+
+			std::string strBenchmarkFileNameAsync = "CL_Logs/";
+			strBenchmarkFileNameAsync.append(deviceName_);
+			strBenchmarkFileNameAsync.append(engineTag_);
+			strBenchmarkFileNameAsync.append("_single_model_test_async");
+			strBenchmarkFileNameAsync.append(std::to_string(aFrameRate));
+			strBenchmarkFileNameAsync.append("dimensions");
+			strBenchmarkFileNameAsync.append(std::to_string(n));
+			strBenchmarkFileNameAsync.append(fdtdSynth.getDispatchLabel());
+			strBenchmarkFileNameAsync.append(".csv");
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAsync, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference", "Upload_Time", "Compute_Time", "Readback_Time", "Transfer_Overlap", "Deadline_Misses", "Miss_Fraction", "Worst_Slack" });
+
+			for (size_t i = 0; i != bufferSizesLength; ++i)
+			{
+				uint64_t currentBufferLength = bufferSizes[i];
+				setBufferLength(currentBufferLength);
+				if (currentBufferLength > aFrameRate)
+					break;
+
+				std::string strBenchmarkName = std::to_string(currentBufferLength);
+
+				uint32_t centre = n / 2;
+				uint32_t inputPosition[2] = { centre,centre };
+				uint32_t outputPosition[2] = { centre + 10, centre + 10 };
+				float boundaryValue = 1.0;
+				fdtdSynth.createModel(modelPathAuto, boundaryValue, inputPosition, outputPosition);
+
+				float propagationCoefficient = 0.0018;
+				float dampingCoefficient = 0.000005;
+				fdtdSynth.updateCoefficient("lambda", 10, propagationCoefficient);
+				fdtdSynth.updateCoefficient("mu", 9, dampingCoefficient);
+
+				if (isWarmup)
+				{
+					impulse(currentBufferLength, 5, inputBuffer_);
+					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
+				}
+				impulse(currentBufferLength, 5, inputBuffer_);
+				fdtdSynth.resetPipelineTimes();
+
+				uint64_t numSamplesSubmitted = 0;
+				uint64_t numSamplesComputed = 0;
+				std::chrono::time_point<std::chrono::steady_clock> streamStart = std::chrono::steady_clock::now();
+				fdtdSynth.submitBuffer(inputBuffer_, currentBufferLength);
+				numSamplesSubmitted += currentBufferLength;
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				while (numSamplesComputed < aFrameRate)
+				{
+					clBenchmarker_.startTimer(timer);
+					if (numSamplesSubmitted < aFrameRate)
+					{
+						fdtdSynth.submitBuffer(inputBuffer_, currentBufferLength);
+						numSamplesSubmitted += currentBufferLength;
+					}
+					fdtdSynth.collectBuffer(outputBuffer_);
+					clBenchmarker_.pauseTimer(timer);
+
+					for (int j = 0; j != currentBufferLength; ++j)
+						soundBuffer_[numSamplesComputed + j] = outputBuffer_[j];
+
+					numSamplesComputed += currentBufferLength;
+				}
+				double streamTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - streamStart).count();
+
+				//Share of transfer time hidden behind compute - 0 when the stages ran back to back, 1 when transfers were entirely overlapped//
+				double transferTime = fdtdSynth.getUploadTime() + fdtdSynth.getReadbackTime();
+				double serialTime = transferTime + fdtdSynth.getComputeTime();
+				double overlap = transferTime > 0.0 ? (serialTime - streamTime) / transferTime : 0.0;
+				overlap = overlap < 0.0 ? 0.0 : (overlap > 1.0 ? 1.0 : overlap);
+				clBenchmarker_.recordMetric(strBenchmarkName, "Upload_Time", fdtdSynth.getUploadTime());
+				clBenchmarker_.recordMetric(strBenchmarkName, "Compute_Time", fdtdSynth.getComputeTime());
+				clBenchmarker_.recordMetric(strBenchmarkName, "Readback_Time", fdtdSynth.getReadbackTime());
+				clBenchmarker_.recordMetric(strBenchmarkName, "Transfer_Overlap", overlap);
+				recordRealtimeDimension("single_model_test_async", currentBufferLength, n, strBenchmarkName);
+				clBenchmarker_.elapsedTimer(strBenchmarkName);
+
+				std::string strBenchmarkFileNameAsyncWav = strBenchmarkFileNameAsync;
+				strBenchmarkFileNameAsyncWav.append("bufferlength");
+				strBenchmarkFileNameAsyncWav.append(std::to_string(i));
+				strBenchmarkFileNameAsyncWav.append(".wav");
+				outputAudioFile(strBenchmarkFileNameAsyncWav.c_str(), soundBuffer_, aFrameRate, aFrameRate);
+				std::cout << "cl_runSingleModelTestAsync successful: Inspect audio log \"cl_runSingleModelTestAsync.wav\"" << std::endl << std::endl;
+			}
+		}
+		logMaxRealtimeGridSize("single_model_test_async", aFrameRate);
 	}
 	void runSimpleMultiModelTestRealtime(size_t aFrameRate, bool isWarmup)
 	{
@@ -345,8 +580,10 @@ private:
 			std::string strBenchmarkFileNameAuto = "CL_Logs/";
 			strBenchmarkFileNameAuto.append(deviceName_);
 			std::string strBenchmarkFileNameManual = strBenchmarkFileNameAuto;
-			strBenchmarkFileNameAuto.append("_cl_multi_model_test_auto");
-			strBenchmarkFileNameManual.append("_cl_multi_model_test_manual");
+			strBenchmarkFileNameAuto.append(engineTag_);
+			strBenchmarkFileNameAuto.append("_multi_model_test_auto");
+			strBenchmarkFileNameManual.append(engineTag_);
+			strBenchmarkFileNameManual.append("_multi_model_test_manual");
 			std::string strFrameRate = std::to_string(aFrameRate);
 			strBenchmarkFileNameAuto.append(strFrameRate);
 			strBenchmarkFileNameManual.append(strFrameRate);
@@ -354,9 +591,11 @@ private:
 			strBenchmarkFileNameManual.append("dimensions");
 			strBenchmarkFileNameAuto.append(std::to_string(n));
 			strBenchmarkFileNameManual.append(std::to_string(n));
+			strBenchmarkFileNameAuto.append(fdtdSynth.getDispatchLabel());
+			strBenchmarkFileNameManual.append(fdtdSynth.getDispatchLabel());
 			strBenchmarkFileNameAuto.append(".csv");
 			strBenchmarkFileNameManual.append(".csv");
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, realtimeFields());
 
 			// AUTO
 			uint64_t numSamplesComputed = 0;
@@ -392,11 +631,14 @@ private:
 				{
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -404,6 +646,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("multi_model_test_auto", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -417,8 +661,11 @@ private:
 				numSamplesComputed = 0;
 			}
 
+			if (!isManualTimed())
+				continue;
+
 			// MANUAL
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, realtimeFields());
 			for (size_t i = 0; i != bufferSizesLength; ++i)
 			{
 				uint64_t currentBufferLength = bufferSizes[i];
@@ -454,11 +701,14 @@ private:
 				{
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -466,6 +716,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("multi_model_test_manual", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -479,6 +731,9 @@ private:
 				numSamplesComputed = 0;
 			}
 		}
+		logMaxRealtimeGridSize("multi_model_test_auto", aFrameRate);
+		if (isManualTimed())
+			logMaxRealtimeGridSize("multi_model_test_manual", aFrameRate);
 	}
 	void runComplexMultiModelTestRealtime(size_t aFrameRate, bool isWarmup)
 	{
@@ -501,8 +756,10 @@ private:
 			std::string strBenchmarkFileNameAuto = "CL_Logs/";
 			strBenchmarkFileNameAuto.append(deviceName_);
 			std::string strBenchmarkFileNameManual = strBenchmarkFileNameAuto;
-			strBenchmarkFileNameAuto.append("_cl_complex_multi_model_test_auto");
-			strBenchmarkFileNameManual.append("_cl_complex_multi_model_test_manual");
+			strBenchmarkFileNameAuto.append(engineTag_);
+			strBenchmarkFileNameAuto.append("_complex_multi_model_test_auto");
+			strBenchmarkFileNameManual.append(engineTag_);
+			strBenchmarkFileNameManual.append("_complex_multi_model_test_manual");
 			std::string strFrameRate = std::to_string(aFrameRate);
 			strBenchmarkFileNameAuto.append(strFrameRate);
 			strBenchmarkFileNameManual.append(strFrameRate);
@@ -510,9 +767,11 @@ private:
 			strBenchmarkFileNameManual.append("dimensions");
 			strBenchmarkFileNameAuto.append(std::to_string(n));
 			strBenchmarkFileNameManual.append(std::to_string(n));
+			strBenchmarkFileNameAuto.append(fdtdSynth.getDispatchLabel());
+			strBenchmarkFileNameManual.append(fdtdSynth.getDispatchLabel());
 			strBenchmarkFileNameAuto.append(".csv");
 			strBenchmarkFileNameManual.append(".csv");
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, realtimeFields());
 
 			// AUTO
 			uint64_t numSamplesComputed = 0;
@@ -570,11 +829,14 @@ private:
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
 				impulse(currentBufferLength, 5, inputBuffer_);
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -582,6 +844,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("complex_multi_model_test_auto", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -595,8 +859,11 @@ private:
 				numSamplesComputed = 0;
 			}
 
+			if (!isManualTimed())
+				continue;
+
 			// MANUAL
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, realtimeFields());
 			for (size_t i = 0; i != bufferSizesLength; ++i)
 			{
 				uint64_t currentBufferLength = bufferSizes[i];
@@ -651,11 +918,14 @@ private:
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
 				impulse(currentBufferLength, 5, inputBuffer_);
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -663,6 +933,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("complex_multi_model_test_manual", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -676,6 +948,9 @@ private:
 				numSamplesComputed = 0;
 			}
 		}
+		logMaxRealtimeGridSize("complex_multi_model_test_auto", aFrameRate);
+		if (isManualTimed())
+			logMaxRealtimeGridSize("complex_multi_model_test_manual", aFrameRate);
 	}
 	void runComplexSingleModelTestRealtime(size_t aFrameRate, bool isWarmup)
 	{
@@ -698,8 +973,10 @@ private:
 			std::string strBenchmarkFileNameAuto = "CL_Logs/";
 			strBenchmarkFileNameAuto.append(deviceName_);
 			std::string strBenchmarkFileNameManual = strBenchmarkFileNameAuto;
-			strBenchmarkFileNameAuto.append("_cl_complex_single_model_test_auto");
-			strBenchmarkFileNameManual.append("_cl_complex_single_model_test_manual");
+			strBenchmarkFileNameAuto.append(engineTag_);
+			strBenchmarkFileNameAuto.append("_complex_single_model_test_auto");
+			strBenchmarkFileNameManual.append(engineTag_);
+			strBenchmarkFileNameManual.append("_complex_single_model_test_manual");
 			std::string strFrameRate = std::to_string(aFrameRate);
 			strBenchmarkFileNameAuto.append(strFrameRate);
 			strBenchmarkFileNameManual.append(strFrameRate);
@@ -707,9 +984,11 @@ private:
 			strBenchmarkFileNameManual.append("dimensions");
 			strBenchmarkFileNameAuto.append(std::to_string(n));
 			strBenchmarkFileNameManual.append(std::to_string(n));
+			strBenchmarkFileNameAuto.append(fdtdSynth.getDispatchLabel());
+			strBenchmarkFileNameManual.append(fdtdSynth.getDispatchLabel());
 			strBenchmarkFileNameAuto.append(".csv");
 			strBenchmarkFileNameManual.append(".csv");
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameAuto, realtimeFields());
 
 			// AUTO
 			uint64_t numSamplesComputed = 0;
@@ -746,11 +1025,14 @@ private:
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
 				impulse(currentBufferLength, 5, inputBuffer_);
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -758,6 +1040,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("complex_single_model_test_auto", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -771,8 +1055,11 @@ private:
 				numSamplesComputed = 0;
 			}
 
+			if (!isManualTimed())
+				continue;
+
 			// MANUAL
-			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			clBenchmarker_ = Benchmarker(strBenchmarkFileNameManual, realtimeFields());
 			for (size_t i = 0; i != bufferSizesLength; ++i)
 			{
 				uint64_t currentBufferLength = bufferSizes[i];
@@ -815,11 +1102,14 @@ private:
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
 				}
 				impulse(currentBufferLength, 5, inputBuffer_);
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(currentBufferLength, aFrameRate));
+				fdtdSynth.resetLaunchProfile();
 				while (numSamplesComputed < aFrameRate)
 				{
-					clBenchmarker_.startTimer(strBenchmarkName);
+					clBenchmarker_.startTimer(timer);
 					fdtdSynth.fillBuffer(inputBuffer_, outputBuffer_, currentBufferLength);
-					clBenchmarker_.pauseTimer(strBenchmarkName);
+					clBenchmarker_.pauseTimer(timer);
 
 					//Log audio for inspection if necessary//
 					for (int j = 0; j != currentBufferLength; ++j)
@@ -827,6 +1117,8 @@ private:
 
 					numSamplesComputed += currentBufferLength;
 				}
+				recordLaunchProfile(strBenchmarkName);
+				recordRealtimeDimension("complex_single_model_test_manual", currentBufferLength, n, strBenchmarkName);
 				clBenchmarker_.elapsedTimer(strBenchmarkName);
 
 				//Save audio to file for inspection//
@@ -840,6 +1132,9 @@ private:
 				numSamplesComputed = 0;
 			}
 		}
+		logMaxRealtimeGridSize("complex_single_model_test_auto", aFrameRate);
+		if (isManualTimed())
+			logMaxRealtimeGridSize("complex_single_model_test_manual", aFrameRate);
 	}
 	static void outputAudioFile(const char* aPath, float* aAudioBuffer, uint32_t aAudioLength, uint32_t aSampleRate)
 	{
@@ -858,8 +1153,29 @@ private:
 		audioFile.save(aPath);
 	}
 public:
-	GPU_Benchmark_OpenCL(std::string aDeviceName, uint32_t aPlatform, uint32_t aDevice) : fdtdSynth(Implementation::OPENCL, aDevice, 44100, 0.001), deviceName_(aDeviceName), clBenchmarker_("CL_Logs/openclog.csv", { "Test_Name", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" })
+	GPU_Benchmark_OpenCL(std::string aDeviceName, uint32_t aPlatform, uint32_t aDevice, Implementation aImplementation = Implementation::OPENCL) : implementation_(aImplementation), deviceName_(aDeviceName), clBenchmarker_("CL_Logs/openclog.csv", { "Test_Name", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" }), fdtdSynth(aImplementation, aDevice, 44100, 0.001)
 	{
+		//Host engines have no launch overhead to amortise//
+		stepsPerLaunchSweep_ = { 1 };
+		switch (implementation_)
+		{
+		case Implementation::CPU:
+			engineTag_ = "_cpu";
+			break;
+		case Implementation::CPU_SIMD:
+			engineTag_ = "_simd";
+			deviceName_.append("_");
+			deviceName_.append(fdtdSynth.getHostArchitecture());
+			break;
+		default:
+			engineTag_ = "_cl";
+			stepsPerLaunchSweep_ = { 1, 2, 4, 8, 16, 32 };
+
+			//Sampled rather than every launch, so single sample buffers aren't dominated by event overhead//
+			fdtdSynth.setLaunchProfileInterval(8);
+			break;
+		}
+
 		currentPlatformIdx_ = aPlatform;
 		currentDeviceIdx_ = aDevice;
 		bufferSizes[0] = 1;
@@ -897,7 +1213,8 @@ public:
 				uint64_t currentBufferSize = bufferSizes[i];
 				std::string benchmarkFileName = "CL_Logs/";
 				benchmarkFileName.append(deviceName_);
-				benchmarkFileName.append("_cl_");
+				benchmarkFileName.append(engineTag_);
+				benchmarkFileName.append("_");
 				std::string strBufferSize = std::to_string(currentBufferSize);
 				benchmarkFileName.append("buffersize");
 				benchmarkFileName.append(strBufferSize);
@@ -914,10 +1231,528 @@ public:
 	}
 	void runRealTimeBenchmarks(uint32_t aSampleRate, bool isWarmup)
 	{
-		runSimpleSingleModelTestRealtime(aSampleRate, false);
-		//runSimpleMultiModelTestRealtime(aSampleRate, false);
-		//runComplexSingleModelTestRealtime(aSampleRate, false);
-		//runComplexMultiModelTestRealtime(aSampleRate, false);
+		for (uint32_t k = 0; k != stepsPerLaunchSweep_.size(); ++k)
+		{
+			fdtdSynth.setStepsPerLaunch(stepsPerLaunchSweep_[k]);
+			runSimpleSingleModelTestRealtime(aSampleRate, false);
+			runSimpleSingleModelTestAsync(aSampleRate, false);
+			//runSimpleMultiModelTestRealtime(aSampleRate, false);
+			//runComplexSingleModelTestRealtime(aSampleRate, false);
+			//runComplexMultiModelTestRealtime(aSampleRate, false);
+		}
+
+		//Single launch per buffer, logged as its own "persistent" test//
+		if (implementation_ == Implementation::OPENCL)
+		{
+			runPersistent([&]() { runSimpleSingleModelTestRealtime(aSampleRate, false); });
+
+			runDispatchComparison(aSampleRate);
+			runBatchedVoicesTest(aSampleRate);
+			runPrecisionComparison(aSampleRate);
+			runIdStorageComparison(aSampleRate);
+			runFoldingComparison(aSampleRate);
+			runAutomationComparison(aSampleRate);
+			runHostComparison(aSampleRate);
+		}
+	}
+	//Runs aComparison over each of its models and dimensions - A second of audio per variant from the same impulse. The first variant timed is the baseline.//
+	//Logs the speedup of each variant over the baseline, its throughput, and its largest and RMS output difference from the baseline or the reference//
+	void runComparison(const Comparison& aComparison, size_t aFrameRate)
+	{
+		std::string strBenchmarkFileName = "CL_Logs/";
+		strBenchmarkFileName.append(deviceName_);
+		strBenchmarkFileName.append(engineTag_);
+		strBenchmarkFileName.append("_");
+		strBenchmarkFileName.append(aComparison.label);
+		strBenchmarkFileName.append(std::to_string(aFrameRate));
+		strBenchmarkFileName.append(".csv");
+		std::vector<std::string> fields = { "Test_Name", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" };
+		fields.insert(fields.end(), aComparison.metrics.begin(), aComparison.metrics.end());
+		clBenchmarker_ = Benchmarker(strBenchmarkFileName, fields);
+
+		uint32_t stepsPerLaunch = fdtdSynth.getStepsPerLaunch();
+		fdtdSynth.setStepsPerLaunch(1);
+		for (uint32_t m = 0; m != aComparison.models.size(); ++m)
+		{
+			const Auto_Test_Model& model = aComparison.models[m];
+			for (uint32_t n = minDimensionSize_; n <= maxDimensionSize_; n *= 2)
+			{
+				std::string modelPath = model.path + std::to_string(n) + ".json";
+				std::string strModelName = modelPath.substr(modelPath.rfind('/') + 1);
+				strModelName = strModelName.substr(0, strModelName.rfind(".json"));
+
+				std::vector<double> expected;
+				bool isBaseline = true;
+				double baselineTime = 0.0;
+				for (uint32_t k = 0; k != aComparison.numVariants; ++k)
+				{
+					FDTD_Accelerated& synth = aComparison.setup(k);
+					uint32_t centre = n / 2;
+					uint32_t inputPosition[2] = { centre, centre };
+					uint32_t outputPosition[2] = { centre + 10, centre + 10 };
+					synth.createModel(modelPath, 1.0, inputPosition, outputPosition);
+					for (uint32_t i = 0; i != model.coefficients.size(); ++i)
+						synth.updateCoefficient(model.coefficients[i].first, model.coefficients[i].second.first, model.coefficients[i].second.second);
+
+					std::string label = aComparison.prepare(synth, model, k);
+					if (label.empty())
+						continue;
+					if (isBaseline && aComparison.reference)
+						expected = aComparison.reference(synth);
+					bool isRecorded = isBaseline && expected.empty();
+
+					std::string strBenchmarkName = strModelName + "_" + label;
+					Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+					double maxError = 0.0;
+					double squaredError = 0.0;
+					uint64_t numCompared = 0;
+					uint64_t numSamplesComputed = 0;
+					for (; numSamplesComputed < aFrameRate; numSamplesComputed += comparisonBufferLength_)
+					{
+						//Host engines consume their input, so every buffer starts from a fresh impulse//
+						impulse(comparisonBufferLength_, 5, inputBuffer_);
+						clBenchmarker_.startTimer(timer);
+						if (aComparison.fill)
+							aComparison.fill(synth, model, k, numSamplesComputed);
+						else
+							synth.fillBuffer(inputBuffer_, outputBuffer_, comparisonBufferLength_);
+						clBenchmarker_.pauseTimer(timer);
+
+						for (uint64_t i = 0; i != comparisonBufferLength_; ++i)
+						{
+							if (isRecorded)
+								expected.push_back(outputBuffer_[i]);
+							else if (numSamplesComputed + i < expected.size())
+							{
+								double error = std::abs(outputBuffer_[i] - expected[numSamplesComputed + i]);
+								maxError = std::max(maxError, error);
+								squaredError += error * error;
+								++numCompared;
+							}
+						}
+					}
+
+					double totalTime = clBenchmarker_.getTotalTime(strBenchmarkName);
+					baselineTime = isBaseline ? totalTime : baselineTime;
+					isBaseline = false;
+					double cellsPerSecond = totalTime != 0.0 ? (double)synth.getGridCellCount() * numSamplesComputed / (totalTime / 1000.0) : 0.0;
+					clBenchmarker_.recordMetric(strBenchmarkName, "Active_Cells", synth.getActiveCellCount());
+					clBenchmarker_.recordMetric(strBenchmarkName, "Grid_Cells", synth.getGridCellCount());
+					clBenchmarker_.recordMetric(strBenchmarkName, "Cells_Per_Second", cellsPerSecond);
+					clBenchmarker_.recordMetric(strBenchmarkName, "Speedup", totalTime != 0.0 ? baselineTime / totalTime : 0.0);
+					clBenchmarker_.recordMetric(strBenchmarkName, "Max_Error", maxError);
+					clBenchmarker_.recordMetric(strBenchmarkName, "RMS_Error", numCompared != 0 ? std::sqrt(squaredError / numCompared) : 0.0);
+					clBenchmarker_.elapsedTimer(strBenchmarkName);
+				}
+			}
+		}
+		fdtdSynth.setStepsPerLaunch(stepsPerLaunch);
+	}
+	//Sparse, bucketed sparse, per-material split dispatch and the pitched layout with and without neighbour masks, against the folded dense kernel.//
+	//They all step the same generic material table, so that is the baseline. The model's own fdtdKernel is timed alongside, as "dense_model"//
+	void runDispatchComparison(size_t aFrameRate)
+	{
+		Comparison comparison;
+		comparison.label = "dispatch_comparison";
+		comparison.metrics = { "Active_Cells", "Grid_Cells", "Speedup" };
+		comparison.models = autoTestModels();
+		comparison.numVariants = 7;
+		comparison.setup = [this](uint32_t aVariant) -> FDTD_Accelerated&
+		{
+			fdtdSynth.setCoefficientFolding(aVariant == 0);
+			fdtdSynth.setSparseDispatch(aVariant == 2 || aVariant == 3, aVariant == 3);
+			fdtdSynth.setSplitDispatch(aVariant == 4);
+			fdtdSynth.setPitchedLayout(aVariant == 5 || aVariant == 6);
+			fdtdSynth.setNeighbourMasks(aVariant == 6);
+			return fdtdSynth;
+		};
+		comparison.prepare = [](FDTD_Accelerated& aSynth, const Auto_Test_Model&, uint32_t aVariant)
+		{
+			if (aVariant == 0)
+				return aSynth.getFoldingLabel() == "folded" ? std::string("dense_generic") : std::string();
+			return aVariant == 1 ? std::string("dense_model") : aSynth.getDispatchLabel();
+		};
+		runComparison(comparison, aFrameRate);
+
+		fdtdSynth.setCoefficientFolding(false);
+		fdtdSynth.setSparseDispatch(false);
+		fdtdSynth.setSplitDispatch(false);
+		fdtdSynth.setPitchedLayout(false);
+		fdtdSynth.setNeighbourMasks(false);
+	}
+	//Each storage precision of the pitched layout, against fp32. Errors are of the first few buffers against FDTD_Reference's double render,//
+	//which is too slow for a whole second//
+	void runPrecisionComparison(size_t aFrameRate)
+	{
+		const std::vector<std::pair<StoragePrecision, bool>> precisions = { { STORAGE_SINGLE, false }, { STORAGE_HALF, false }, { STORAGE_DOUBLE, false }, { STORAGE_DOUBLE, true } };
+		const uint64_t referenceLength = 4 * comparisonBufferLength_;
+
+		Comparison comparison;
+		comparison.label = "precision_comparison";
+		comparison.metrics = { "Cells_Per_Second", "Speedup", "Max_Error", "RMS_Error" };
+		comparison.models = autoTestModels();
+		comparison.numVariants = precisions.size();
+		comparison.setup = [this, &precisions](uint32_t aVariant) -> FDTD_Accelerated&
+		{
+			fdtdSynth.setStoragePrecision(precisions[aVariant].first, precisions[aVariant].second);
+			return fdtdSynth;
+		};
+		comparison.prepare = [](FDTD_Accelerated& aSynth, const Auto_Test_Model&, uint32_t) { return aSynth.isPitchedLayoutReady() ? aSynth.getPrecisionLabel() : std::string(); };
+		comparison.reference = [this, referenceLength](FDTD_Accelerated& aSynth)
+		{
+			impulse(comparisonBufferLength_, 5, inputBuffer_);
+			std::vector<float> referenceInput(referenceLength);
+			for (uint64_t i = 0; i != referenceLength; ++i)
+				referenceInput[i] = inputBuffer_[i % comparisonBufferLength_];
+			return aSynth.renderReference(referenceInput.data(), referenceLength);
+		};
+		fdtdSynth.setPitchedLayout(true);
+		runComparison(comparison, aFrameRate);
+
+		fdtdSynth.setPitchedLayout(false);
+		fdtdSynth.setStoragePrecision(STORAGE_SINGLE);
+	}
+	//The pitched layout with its ids as int32, uint8 and an image, against int32. The output difference should be 0. Storage the device can't take falls//
+	//back and isn't timed twice//
+	void runIdStorageComparison(size_t aFrameRate)
+	{
+		const std::vector<IdStorage> idStorages = { ID_INT, ID_UCHAR, ID_IMAGE };
+		std::vector<std::string> timedLabels;
+
+		Comparison comparison;
+		comparison.label = "id_storage_comparison";
+		comparison.metrics = { "Cells_Per_Second", "Speedup", "Max_Error" };
+		comparison.models = autoTestModels();
+		comparison.numVariants = idStorages.size();
+		comparison.setup = [this, &idStorages](uint32_t aVariant) -> FDTD_Accelerated&
+		{
+			fdtdSynth.setIdStorage(idStorages[aVariant]);
+			return fdtdSynth;
+		};
+		comparison.prepare = [&timedLabels](FDTD_Accelerated& aSynth, const Auto_Test_Model&, uint32_t aVariant)
+		{
+			timedLabels.resize(aVariant == 0 ? 0 : timedLabels.size());
+			std::string label = aSynth.getIdStorageLabel();
+			if (!aSynth.isPitchedLayoutReady() || std::find(timedLabels.begin(), timedLabels.end(), label) != timedLabels.end())
+				return std::string();
+			timedLabels.push_back(label);
+			return "ids_" + label;
+		};
+		fdtdSynth.setPitchedLayout(true);
+		runComparison(comparison, aFrameRate);
+
+		fdtdSynth.setPitchedLayout(false);
+		fdtdSynth.setIdStorage(ID_INT);
+	}
+	//The dense path with the model's own kernel, the folded kernel and the folded kernel with its coefficients baked in, against the model's kernel//
+	void runFoldingComparison(size_t aFrameRate)
+	{
+		const std::vector<std::pair<bool, bool>> foldings = { { false, false }, { true, false }, { true, true } };
+
+		Comparison comparison;
+		comparison.label = "folding_comparison";
+		comparison.metrics = { "Speedup", "Max_Error" };
+		comparison.models = autoTestModels();
+		comparison.numVariants = foldings.size();
+		comparison.setup = [this, &foldings](uint32_t aVariant) -> FDTD_Accelerated&
+		{
+			fdtdSynth.setCoefficientFolding(foldings[aVariant].first, foldings[aVariant].second);
+			return fdtdSynth;
+		};
+		comparison.prepare = [](FDTD_Accelerated& aSynth, const Auto_Test_Model&, uint32_t) { return aSynth.getFoldingLabel(); };
+		runComparison(comparison, aFrameRate);
+
+		fdtdSynth.setCoefficientFolding(false);
+	}
+	//The folded dense path while each model's first coefficient ramps to double its value over the second. The baseline steps one sample per fillBuffer,//
+	//setting the coefficient before each. Automation does the same ramp sample accurately in full buffers, and is skipped where it's refused//
+	void runAutomationComparison(size_t aFrameRate)
+	{
+		const uint64_t rampLength = aFrameRate;
+		auto ramp = [rampLength](const Auto_Test_Model& aModel)
+		{
+			float startValue = aModel.coefficients[0].second.second;
+			return std::vector<std::pair<uint64_t, float>>{ { 0, startValue }, { rampLength, startValue * 2.0f } };
+		};
+
+		Comparison comparison;
+		comparison.label = "automation_comparison";
+		comparison.metrics = { "Speedup", "Max_Error" };
+		comparison.models = autoTestModels();
+		comparison.numVariants = 2;
+		comparison.setup = [this](uint32_t) -> FDTD_Accelerated& { return fdtdSynth; };
+		comparison.prepare = [&ramp](FDTD_Accelerated& aSynth, const Auto_Test_Model& aModel, uint32_t aVariant)
+		{
+			const std::string& automated = aModel.coefficients[0].first;
+			if (aVariant == 0)
+				return automated + "_stepped";
+			if (!aSynth.automateCoefficient(automated, ramp(aModel)))
+				return std::string();
+			return automated + "_automated_" + aSynth.getAutomationLabel();
+		};
+		comparison.fill = [this, &ramp](FDTD_Accelerated& aSynth, const Auto_Test_Model& aModel, uint32_t aVariant, uint64_t aSample)
+		{
+			if (aVariant != 0)
+			{
+				aSynth.fillBuffer(inputBuffer_, outputBuffer_, comparisonBufferLength_);
+				return;
+			}
+			Automation_Stream stream = Automation_Stream::ramp(ramp(aModel));
+			for (uint64_t i = 0; i != comparisonBufferLength_; ++i)
+			{
+				aSynth.updateCoefficient(aModel.coefficients[0].first, stream.valueAt(aSample + i));
+				aSynth.fillBuffer(inputBuffer_ + i, outputBuffer_ + i, 1);
+			}
+		};
+		fdtdSynth.setCoefficientFolding(true);
+		runComparison(comparison, aFrameRate);
+
+		fdtdSynth.setCoefficientFolding(false);
+	}
+	//Every auto and manual model through its own fdtdKernel on the device, then through the scalar and vectorised host engines, against the device//
+	void runHostComparison(size_t aFrameRate)
+	{
+		const std::vector<Implementation> hosts = { Implementation::CPU, Implementation::CPU_SIMD };
+		std::unique_ptr<FDTD_Accelerated> host;
+
+		Comparison comparison;
+		comparison.label = "host_comparison";
+		comparison.metrics = { "Speedup", "Max_Error", "RMS_Error" };
+		comparison.models = autoTestModels();
+		comparison.models.insert(comparison.models.end(), manualTestModels().begin(), manualTestModels().end());
+		comparison.numVariants = hosts.size() + 1;
+		comparison.setup = [this, &hosts, &host](uint32_t aVariant) -> FDTD_Accelerated&
+		{
+			if (aVariant == 0)
+				return fdtdSynth;
+			host.reset(new FDTD_Accelerated(hosts[aVariant - 1], currentDeviceIdx_, sampleRate_, 0.001));
+			return *host;
+		};
+		comparison.prepare = [](FDTD_Accelerated& aSynth, const Auto_Test_Model&, uint32_t aVariant)
+		{
+			return aVariant == 0 ? std::string("device") : aVariant == 1 ? std::string("cpu") : "simd_" + aSynth.getHostArchitecture();
+		};
+		runComparison(comparison, aFrameRate);
+	}
+	//Voices per device - Times a second of audio for 1, 2, 4... voices of the simple single model, all advanced by each batched launch at a fixed buffer length.//
+	//Logs how many voices each batch sustains in real time, and the largest batch per dimension with no missed deadline//
+	void runBatchedVoicesTest(size_t aFrameRate)
+	{
+		const uint64_t bufferLength = 512;
+		const uint32_t maxVoices = 64;
+
+		std::string strBenchmarkFileName = "CL_Logs/";
+		strBenchmarkFileName.append(deviceName_);
+		strBenchmarkFileName.append(engineTag_);
+		strBenchmarkFileName.append("_batched_voices");
+		strBenchmarkFileName.append(std::to_string(aFrameRate));
+		strBenchmarkFileName.append(".csv");
+		clBenchmarker_ = Benchmarker(strBenchmarkFileName, { "Test_Name", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference", "Deadline_Misses", "Miss_Fraction", "Worst_Slack", "Voices", "Realtime_Voices" });
+
+		for (uint32_t n = minDimensionSize_; n <= maxDimensionSize_; n *= 2)
+		{
+			std::string modelPath = "resources/kernels/auto/simple_single_model/simpleSingleModelTestAuto" + std::to_string(n) + ".json";
+			uint32_t maxRealtimeVoices = 0;
+			for (uint32_t numVoices = 1; numVoices <= maxVoices; numVoices *= 2)
+			{
+				std::string strBenchmarkName = "dimensions" + std::to_string(n) + "_voices" + std::to_string(numVoices);
+
+				uint32_t centre = n / 2;
+				uint32_t inputPosition[2] = { centre, centre };
+				uint32_t outputPosition[2] = { centre + 10, centre + 10 };
+				fdtdSynth.createModel(modelPath, 1.0, inputPosition, outputPosition);
+				if (!fdtdSynth.setVoiceCount(numVoices))
+					break;
+				fdtdSynth.updateCoefficient("lambda", 10, 0.0018f);
+				fdtdSynth.updateCoefficient("mu", 9, 0.000005f);
+
+				//Spread the voices' excitations, so each voice is a different note of the same instrument//
+				for (uint32_t v = 0; v != numVoices; ++v)
+				{
+					int voiceInput[2] = { (int)(centre - v % (centre / 2)), (int)centre };
+					int voiceOutput[2] = { (int)outputPosition[0], (int)outputPosition[1] };
+					fdtdSynth.setVoicePositions(v, voiceInput, voiceOutput);
+				}
+
+				std::vector<float> inputs(bufferLength * numVoices, 0.0f);
+				std::vector<float> outputs(bufferLength * numVoices);
+				for (uint32_t i = 0; i != 5; ++i)
+					std::fill(inputs.begin() + i * numVoices, inputs.begin() + (i + 1) * numVoices, 0.5f);
+
+				Benchmarker::Timer_Handle timer = clBenchmarker_.registerTimer(strBenchmarkName);
+				clBenchmarker_.setDeadline(strBenchmarkName, bufferDeadline(bufferLength, aFrameRate));
+				for (uint64_t numSamplesComputed = 0; numSamplesComputed < aFrameRate; numSamplesComputed += bufferLength)
+				{
+					clBenchmarker_.startTimer(timer);
+					fdtdSynth.fillBuffer(inputs.data(), outputs.data(), bufferLength);
+					clBenchmarker_.pauseTimer(timer);
+				}
+
+				//Seconds of audio computed per second, over all voices//
+				double totalTime = clBenchmarker_.getTotalTime(strBenchmarkName);
+				double realtimeVoices = totalTime != 0.0 ? numVoices * bufferDeadline(aFrameRate, sampleRate_) / totalTime : 0.0;
+				bool isRealtime = clBenchmarker_.getDeadlineMisses(strBenchmarkName) == 0;
+				maxRealtimeVoices = isRealtime && maxRealtimeVoices == numVoices / 2 ? numVoices : maxRealtimeVoices;
+				clBenchmarker_.recordMetric(strBenchmarkName, "Voices", numVoices);
+				clBenchmarker_.recordMetric(strBenchmarkName, "Realtime_Voices", realtimeVoices);
+				clBenchmarker_.elapsedTimer(strBenchmarkName);
+			}
+			std::cout << "Max real-time voices at " << n << "x" << n << ", buffer size " << bufferLength << ": " << maxRealtimeVoices << std::endl;
+		}
+		fdtdSynth.setVoiceCount(0);
+	}
+	//Searches fdtdKernel's local work group sizes for each auto model and dimension, logging every size tried. The fastest is kept by FDTD_Accelerated,//
+	//so later runs on this device start from it without searching again//
+	void runWorkGroupTuning()
+	{
+		if (implementation_ != Implementation::OPENCL)
+			return;
+
+		std::string strSearchFileName = "CL_Logs/";
+		strSearchFileName.append(deviceName_);
+		strSearchFileName.append(engineTag_);
+		strSearchFileName.append("_work_group_search.csv");
+		CSV_Logger searchLogger(strSearchFileName, { "Model", "Local_X", "Local_Y", "Group_Size", "Time_Per_Step", "Status", "Is_Best" });
+
+		const std::vector<Auto_Test_Model>& models = autoTestModels();
+		for (uint32_t m = 0; m != models.size(); ++m)
+		{
+			for (uint32_t n = minDimensionSize_; n <= maxDimensionSize_; n *= 2)
+			{
+				std::string modelPath = models[m].path + std::to_string(n) + ".json";
+				std::string strModelName = modelPath.substr(modelPath.rfind('/') + 1);
+				strModelName = strModelName.substr(0, strModelName.rfind(".json"));
+
+				uint32_t centre = n / 2;
+				uint32_t inputPosition[2] = { centre, centre };
+				uint32_t outputPosition[2] = { centre + 10, centre + 10 };
+				fdtdSynth.createModel(modelPath, 1.0, inputPosition, outputPosition);
+				for (uint32_t i = 0; i != models[m].coefficients.size(); ++i)
+					fdtdSynth.updateCoefficient(models[m].coefficients[i].first, models[m].coefficients[i].second.first, models[m].coefficients[i].second.second);
+
+				std::vector<Work_Group_Timing> sizes = fdtdSynth.tuneWorkGroup();
+				cl::NDRange best = fdtdSynth.getLocalWorkSize();
+				for (uint32_t i = 0; i != sizes.size(); ++i)
+				{
+					bool isBest = sizes[i].x == best.get()[0] && sizes[i].y == best.get()[1];
+					searchLogger.addRecord({ strModelName, std::to_string(sizes[i].x), std::to_string(sizes[i].y), std::to_string(sizes[i].x * sizes[i].y),
+						std::to_string(sizes[i].timePerStep), std::to_string(sizes[i].status), isBest ? "1" : "0" });
+				}
+				std::cout << "Work group size for " << strModelName << ": " << best.get()[0] << "x" << best.get()[1] << " of " << sizes.size() << " tried" << std::endl;
+			}
+		}
+	}
+	//Plate models, the sizes the CPU engines are chasing a real-time budget on//
+	void runComplexRealTimeBenchmarks(uint32_t aSampleRate, bool isWarmup)
+	{
+		for (uint32_t k = 0; k != stepsPerLaunchSweep_.size(); ++k)
+		{
+			fdtdSynth.setStepsPerLaunch(stepsPerLaunchSweep_[k]);
+			runComplexSingleModelTestRealtime(aSampleRate, isWarmup);
+			runComplexMultiModelTestRealtime(aSampleRate, isWarmup);
+		}
+
+		if (implementation_ == Implementation::OPENCL)
+		{
+			runPersistent([&]()
+			{
+				runComplexSingleModelTestRealtime(aSampleRate, isWarmup);
+				runComplexMultiModelTestRealtime(aSampleRate, isWarmup);
+			});
+		}
+	}
+	//Runs aTests with the persistent kernel over the dimensions whose levels stay in local memory. One work-group stepping a larger grid is not what//
+	//the mode is for, and would spend minutes per dimension//
+	void runPersistent(const std::function<void()>& aTests)
+	{
+		uint32_t maxDimensionSize = maxDimensionSize_;
+		while (maxDimensionSize_ >= minDimensionSize_ && !fdtdSynth.isPersistentResident(maxDimensionSize_, maxDimensionSize_))
+			maxDimensionSize_ /= 2;
+
+		if (maxDimensionSize_ >= minDimensionSize_)
+		{
+			fdtdSynth.setPersistentKernel(true);
+			aTests();
+			fdtdSynth.setPersistentKernel(false);
+		}
+		maxDimensionSize_ = maxDimensionSize;
+	}
+	//Streams the simple single model through Audio_Stream for aSeconds per block size, logging underruns and deadline misses//
+	void runStreamingTest(uint32_t aSampleRate, uint32_t aDimension, uint32_t aBlocksAhead, double aSeconds, bool aIsNullDevice)
+	{
+		std::string modelPathAuto = "resources/kernels/auto/simple_single_model/simpleSingleModelTestAuto";
+		modelPathAuto.append(std::to_string(aDimension));
+		modelPathAuto.append(".json");
+
+		std::string strBenchmarkFileNameStream = "CL_Logs/";
+		strBenchmarkFileNameStream.append(deviceName_);
+		strBenchmarkFileNameStream.append(engineTag_);
+		strBenchmarkFileNameStream.append("_streaming_test");
+		strBenchmarkFileNameStream.append(std::to_string(aSampleRate));
+		strBenchmarkFileNameStream.append("dimensions");
+		strBenchmarkFileNameStream.append(std::to_string(aDimension));
+		strBenchmarkFileNameStream.append("blocksahead");
+		strBenchmarkFileNameStream.append(std::to_string(aBlocksAhead));
+		strBenchmarkFileNameStream.append(aIsNullDevice ? "_null" : "");
+		strBenchmarkFileNameStream.append(".csv");
+		clBenchmarker_ = Benchmarker(strBenchmarkFileNameStream, { "Buffer_Size", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference", "Underruns", "Deadline_Misses", "Blocks_Rendered", "Frames_Played", "Max_Compute_Time", "Average_Compute_Time", "Latency" });
+
+		for (size_t i = 0; i != bufferSizesLength; ++i)
+		{
+			//Shorter blocks are below any device's period, and the null device's sleeps couldn't keep time//
+			uint32_t currentBufferLength = bufferSizes[i];
+			if (currentBufferLength < 32)
+				continue;
+
+			std::string strBenchmarkName = std::to_string(currentBufferLength);
+
+			uint32_t centre = aDimension / 2;
+			uint32_t inputPosition[2] = { centre,centre };
+			uint32_t outputPosition[2] = { centre + 10, centre + 10 };
+			float boundaryValue = 1.0;
+			fdtdSynth.createModel(modelPathAuto, boundaryValue, inputPosition, outputPosition);
+
+			float propagationCoefficient = 0.0018;
+			float dampingCoefficient = 0.000005;
+			fdtdSynth.updateCoefficient("lambda", 10, propagationCoefficient);
+			fdtdSynth.updateCoefficient("mu", 9, dampingCoefficient);
+
+			//fillBuffer only ever runs on the stream's compute thread//
+			Audio_Stream stream([this](float* aInput, float* aOutput, uint32_t aNumSteps) { fdtdSynth.fillBuffer(aInput, aOutput, aNumSteps); }, aSampleRate, currentBufferLength, aBlocksAhead, aIsNullDevice);
+			stream.setRecording(aSampleRate);
+			stream.excite(0.5);
+
+			clBenchmarker_.startTimer(strBenchmarkName);
+			stream.run(aSeconds);
+			clBenchmarker_.pauseTimer(strBenchmarkName);
+
+			std::cout << "Streamed " << stream.getFramesPlayed() << " frames to the " << (stream.isNullDevice() ? "null" : "audio") << " device in blocks of " << currentBufferLength << std::endl;
+			clBenchmarker_.recordMetric(strBenchmarkName, "Underruns", stream.getUnderruns());
+			clBenchmarker_.recordMetric(strBenchmarkName, "Deadline_Misses", stream.getDeadlineMisses());
+			clBenchmarker_.recordMetric(strBenchmarkName, "Blocks_Rendered", stream.getBlocksRendered());
+			clBenchmarker_.recordMetric(strBenchmarkName, "Frames_Played", stream.getFramesPlayed());
+			clBenchmarker_.recordMetric(strBenchmarkName, "Max_Compute_Time", stream.getMaxComputeTime());
+			clBenchmarker_.recordMetric(strBenchmarkName, "Average_Compute_Time", stream.getAverageComputeTime());
+			clBenchmarker_.recordMetric(strBenchmarkName, "Latency", stream.getLatency());
+			clBenchmarker_.elapsedTimer(strBenchmarkName);
+
+			//Save the first second played for inspection//
+			std::copy(stream.getRecording(), stream.getRecording() + stream.getRecordingLength(), soundBuffer_);
+			std::string strBenchmarkFileNameStreamWav = strBenchmarkFileNameStream;
+			strBenchmarkFileNameStreamWav.append("bufferlength");
+			strBenchmarkFileNameStreamWav.append(std::to_string(i));
+			strBenchmarkFileNameStreamWav.append(".wav");
+			outputAudioFile(strBenchmarkFileNameStreamWav.c_str(), soundBuffer_, stream.getRecordingLength(), aSampleRate);
+		}
+	}
+	void setStepsPerLaunchSweep(const std::vector<uint32_t>& aStepsPerLaunch)
+	{
+		stepsPerLaunchSweep_ = aStepsPerLaunch;
+	}
+	//1 profiles every kernel launch, 0 turns the Write_Time ... Launch_Run columns off//
+	void setLaunchProfileInterval(uint32_t aInterval)
+	{
+		fdtdSynth.setLaunchProfileInterval(aInterval);
 	}
 
 	static bool openclCompatible()
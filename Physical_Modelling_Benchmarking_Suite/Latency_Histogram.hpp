@@ -0,0 +1,123 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "CSV_Logger.hpp"
+
+//Fixed bucket log-linear histogram of nanosecond durations, in the style of HdrHistogram//
+//Each power of two range is split into subBucketCount_ linear buckets, so a recorded value is off by at most 1/subBucketCount_ of itself//
+//Storage is allocated once in the constructor, so record() is an index calculation and an increment//
+class Latency_Histogram
+{
+private:
+	static const uint32_t subBucketBits_ = 5;
+	static const uint32_t subBucketCount_ = 1 << subBucketBits_;
+	static const uint32_t maxValueBits_ = 48;		//~78 hours in ns, anything longer lands in the last bucket//
+	static const uint32_t numBuckets_ = (maxValueBits_ - subBucketBits_) * subBucketCount_ + subBucketCount_;
+
+	std::vector<uint64_t> counts_;
+	uint64_t totalCount_ = 0;
+	uint64_t minValue_ = UINT64_MAX;
+	uint64_t maxValue_ = 0;
+
+	static uint32_t mostSignificantBit(uint64_t aValue)
+	{
+		uint32_t bit = 0;
+		while (aValue >>= 1)
+			++bit;
+		return bit;
+	}
+	//Values below 2*subBucketCount_ get a bucket each. Above that, bucket width doubles with every power of two//
+	static uint32_t bucketIndex(uint64_t aValue)
+	{
+		if (aValue < 2 * subBucketCount_)
+			return (uint32_t)aValue;
+
+		uint32_t shift = mostSignificantBit(aValue) - subBucketBits_;
+		uint32_t index = shift * subBucketCount_ + (uint32_t)(aValue >> shift);
+		return index < numBuckets_ ? index : numBuckets_ - 1;
+	}
+	static uint64_t bucketLowerBound(uint32_t aIndex)
+	{
+		if (aIndex < 2 * subBucketCount_)
+			return aIndex;
+
+		uint32_t shift = aIndex / subBucketCount_ - 1;
+		return (uint64_t)(aIndex % subBucketCount_ + subBucketCount_) << shift;
+	}
+	static uint64_t bucketUpperBound(uint32_t aIndex)
+	{
+		return aIndex + 1 < numBuckets_ ? bucketLowerBound(aIndex + 1) - 1 : UINT64_MAX;
+	}
+public:
+	Latency_Histogram() : counts_(numBuckets_, 0)
+	{
+	}
+
+	void record(uint64_t aNanoseconds)
+	{
+		++counts_[bucketIndex(aNanoseconds)];
+		++totalCount_;
+		minValue_ = aNanoseconds < minValue_ ? aNanoseconds : minValue_;
+		maxValue_ = aNanoseconds > maxValue_ ? aNanoseconds : maxValue_;
+	}
+	void reset()
+	{
+		std::fill(counts_.begin(), counts_.end(), 0);
+		totalCount_ = 0;
+		minValue_ = UINT64_MAX;
+		maxValue_ = 0;
+	}
+
+	uint64_t count() const
+	{
+		return totalCount_;
+	}
+	uint64_t min() const
+	{
+		return totalCount_ != 0 ? minValue_ : 0;
+	}
+	uint64_t max() const
+	{
+		return maxValue_;
+	}
+	//Smallest value at least aPercentile% of recordings are at or below. Reported as its bucket's upper bound, clamped to the exact max, so tails err high//
+	uint64_t percentile(double aPercentile) const
+	{
+		if (totalCount_ == 0)
+			return 0;
+
+		uint64_t rank = (uint64_t)(aPercentile / 100.0 * totalCount_ + 0.5);
+		rank = rank == 0 ? 1 : (rank > totalCount_ ? totalCount_ : rank);
+
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i != numBuckets_; ++i)
+		{
+			seen += counts_[i];
+			if (seen >= rank)
+				return bucketUpperBound(i) < maxValue_ ? bucketUpperBound(i) : maxValue_;
+		}
+		return maxValue_;
+	}
+
+	//Writes every non-empty bucket as a row of Lower_Bound, Upper_Bound (ns), Count and Cumulative_Fraction//
+	void dump(const std::string aPath) const
+	{
+		CSV_Logger logger(aPath, { "Lower_Bound", "Upper_Bound", "Count", "Cumulative_Fraction" });
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i != numBuckets_; ++i)
+		{
+			if (counts_[i] == 0)
+				continue;
+
+			seen += counts_[i];
+			logger.addRecord({ std::to_string(bucketLowerBound(i)), std::to_string(bucketUpperBound(i)), std::to_string(counts_[i]), std::to_string((double)seen / totalCount_) });
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,353 @@
+#ifndef MODEL_FILE_HPP
+#define MODEL_FILE_HPP
+
+#include <stdint.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "third_party/json.hpp"
+
+//Read only view of a whole file. Pages are mapped copy-on-write, so grids can be written in place without touching the file//
+class Memory_Map
+{
+private:
+	uint8_t* data_ = nullptr;
+	uint64_t size_ = 0;
+#ifdef _WIN32
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+	HANDLE mapping_ = NULL;
+#endif
+public:
+	Memory_Map() {}
+	Memory_Map(const Memory_Map&) = delete;
+	Memory_Map& operator=(const Memory_Map&) = delete;
+	~Memory_Map()
+	{
+		close();
+	}
+
+	bool open(const std::string& aPath)
+	{
+		close();
+#ifdef _WIN32
+		file_ = CreateFileA(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file_ == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+		size_ = size.QuadPart;
+
+		mapping_ = CreateFileMappingA(file_, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (mapping_ != NULL)
+			data_ = (uint8_t*)MapViewOfFile(mapping_, FILE_MAP_COPY, 0, 0, 0);
+#else
+		int file = ::open(aPath.c_str(), O_RDONLY);
+		if (file < 0)
+			return false;
+
+		struct stat status;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			size_ = status.st_size;
+			void* data = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+			data_ = data == MAP_FAILED ? nullptr : (uint8_t*)data;
+		}
+		::close(file);
+#endif
+		if (data_ == nullptr)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+	void close()
+	{
+#ifdef _WIN32
+		if (data_ != nullptr)
+			UnmapViewOfFile(data_);
+		if (mapping_ != NULL)
+			CloseHandle(mapping_);
+		if (file_ != INVALID_HANDLE_VALUE)
+			CloseHandle(file_);
+		mapping_ = NULL;
+		file_ = INVALID_HANDLE_VALUE;
+#else
+		if (data_ != nullptr)
+			munmap(data_, size_);
+#endif
+		data_ = nullptr;
+		size_ = 0;
+	}
+
+	uint8_t* data() const
+	{
+		return data_;
+	}
+	uint64_t size() const
+	{
+		return size_;
+	}
+	bool isOpen() const
+	{
+		return data_ != nullptr;
+	}
+};
+
+//Binary model (.fdtm) - The JSON model's grids and kernel, laid out so loading is a mapping rather than a parse.//
+//Header, then 64 byte aligned sections: id grid (int8 or int32), boundary grid (float), kernel source, then the controllers and interface as JSON text//
+//Grids are stored in the order createModel() fills them, [i * width + j] for buffer[i][j]//
+class Model_File
+{
+public:
+	struct Header
+	{
+		char magic_[4];
+		uint32_t version_;
+		uint32_t width_;
+		uint32_t height_;
+		uint32_t idBytes_;			//1 for int8 ids, 4 for int32 ids the kernels can read as is//
+		uint32_t reserved_;
+		uint64_t idGridOffset_;
+		uint64_t boundaryGridOffset_;
+		uint64_t kernelOffset_;
+		uint64_t kernelLength_;
+		uint64_t metadataOffset_;
+		uint64_t metadataLength_;
+	};
+	static const uint32_t version_ = 1;
+private:
+	static const uint64_t alignment_ = 64;
+
+	Memory_Map map_;
+	const Header* header_ = nullptr;
+
+	static uint64_t align(uint64_t aOffset)
+	{
+		return (aOffset + alignment_ - 1) / alignment_ * alignment_;
+	}
+	static void writePadding(std::ofstream& aFile, uint64_t aOffset)
+	{
+		static const char zeros[alignment_] = {};
+		uint64_t position = (uint64_t)aFile.tellp();
+		aFile.write(zeros, aOffset - position);
+	}
+	bool isValid() const
+	{
+		if (map_.size() < sizeof(Header))
+			return false;
+
+		const Header& header = *(const Header*)map_.data();
+		uint64_t numCells = (uint64_t)header.width_ * header.height_;
+		return memcmp(header.magic_, "FDTM", 4) == 0 && header.version_ == version_
+			&& (header.idBytes_ == 1 || header.idBytes_ == 4)
+			&& header.idGridOffset_ + numCells * header.idBytes_ <= map_.size()
+			&& header.boundaryGridOffset_ + numCells * sizeof(float) <= map_.size()
+			&& header.kernelOffset_ + header.kernelLength_ <= map_.size()
+			&& header.metadataOffset_ + header.metadataLength_ <= map_.size();
+	}
+public:
+	//Marks the outer cells as boundary, exactly as createModel() always has for JSON models//
+	static void fillEdgeBoundary(float* aBoundaryGrid, uint32_t aWidth, uint32_t aHeight)
+	{
+		for (uint32_t i = 0; i != aWidth; ++i)
+		{
+			for (uint32_t j = 0; j != aHeight; ++j)
+			{
+				if (i == 0 || j == 0 || i == aWidth - 1 || i == aHeight - 1)
+					aBoundaryGrid[i*aWidth + j] = 1.0;
+				else
+					aBoundaryGrid[i*aWidth + j] = 0.0;
+			}
+		}
+	}
+	//model.json -> model.fdtm, the path createModel() looks for before parsing the JSON//
+	static std::string binaryPath(const std::string& aJsonPath)
+	{
+		size_t extension = aJsonPath.rfind(".json");
+		return (extension == std::string::npos ? aJsonPath : aJsonPath.substr(0, extension)) + ".fdtm";
+	}
+
+	//True when aJsonPath has a binary twin at least as new as itself, so an edited JSON model is never shadowed by a stale conversion//
+	static bool isConverted(const std::string& aJsonPath)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type binaryTime = std::filesystem::last_write_time(binaryPath(aJsonPath), error);
+		if (error)
+			return false;
+		std::filesystem::file_time_type jsonTime = std::filesystem::last_write_time(aJsonPath, error);
+		return error || binaryTime >= jsonTime;
+	}
+	//Converts every .json model under aDirectory, writing each .fdtm beside its source. Returns how many were converted//
+	static uint32_t convertDirectory(const std::string& aDirectory, bool aIsCompact = false)
+	{
+		uint32_t numConverted = 0;
+		std::error_code error;
+		for (std::filesystem::recursive_directory_iterator it(aDirectory, error), end; !error && it != end; it.increment(error))
+		{
+			if (it->path().extension() != ".json")
+				continue;
+
+			std::string jsonPath = it->path().string();
+			if (convert(jsonPath, binaryPath(jsonPath), aIsCompact))
+			{
+				std::cout << "Model_File: Converted " << jsonPath << std::endl;
+				++numConverted;
+			}
+			else
+				std::cout << "Model_File: Failed to convert " << jsonPath << std::endl;
+		}
+		return numConverted;
+	}
+	//Converts a JSON model. aIsCompact stores ids as int8 when they fit, at the cost of widening them on load rather than uploading from the mapping//
+	static bool convert(const std::string& aJsonPath, const std::string& aBinaryPath, bool aIsCompact = false)
+	{
+		std::ifstream ifs(aJsonPath);
+		if (!ifs.is_open())
+			return false;
+		nlohmann::json jsonFile = nlohmann::json::parse(ifs);
+
+		Header header = {};
+		memcpy(header.magic_, "FDTM", 4);
+		header.version_ = version_;
+		header.width_ = jsonFile["buffer"].size();
+		header.height_ = jsonFile["buffer"][0].size();
+		const uint64_t numCells = (uint64_t)header.width_ * header.height_;
+
+		std::vector<int32_t> idGrid(numCells, 0);
+		int32_t minId = 0;
+		int32_t maxId = 0;
+		for (uint32_t i = 0; i != header.width_; ++i)
+		{
+			for (uint32_t j = 0; j != header.height_; ++j)
+			{
+				int32_t id = jsonFile["buffer"][i][j];
+				idGrid[i*header.width_ + j] = id;
+				minId = id < minId ? id : minId;
+				maxId = id > maxId ? id : maxId;
+			}
+		}
+		header.idBytes_ = aIsCompact && minId >= INT8_MIN && maxId <= INT8_MAX ? 1 : 4;
+
+		std::vector<float> boundaryGrid(numCells);
+		fillEdgeBoundary(boundaryGrid.data(), header.width_, header.height_);
+
+		//The first controller's kernel, the one the model runs, has its own section. Everything else is kept as JSON//
+		std::string kernelSource = jsonFile["controllers"][0]["physics_kernel"];
+		nlohmann::json metadata;
+		metadata["controllers"] = jsonFile["controllers"];
+		metadata["controllers"][0].erase("physics_kernel");
+		if (jsonFile.count("interface") != 0)
+			metadata["interface"] = jsonFile["interface"];
+		std::string metadataText = metadata.dump();
+
+		header.idGridOffset_ = align(sizeof(Header));
+		header.boundaryGridOffset_ = align(header.idGridOffset_ + numCells * header.idBytes_);
+		header.kernelOffset_ = align(header.boundaryGridOffset_ + numCells * sizeof(float));
+		header.kernelLength_ = kernelSource.size();
+		header.metadataOffset_ = align(header.kernelOffset_ + header.kernelLength_);
+		header.metadataLength_ = metadataText.size();
+
+		std::ofstream file(aBinaryPath, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		file.write((const char*)&header, sizeof(Header));
+		writePadding(file, header.idGridOffset_);
+		if (header.idBytes_ == 1)
+		{
+			std::vector<int8_t> compactGrid(idGrid.begin(), idGrid.end());
+			file.write((const char*)compactGrid.data(), numCells);
+		}
+		else
+			file.write((const char*)idGrid.data(), numCells * sizeof(int32_t));
+		writePadding(file, header.boundaryGridOffset_);
+		file.write((const char*)boundaryGrid.data(), numCells * sizeof(float));
+		writePadding(file, header.kernelOffset_);
+		file.write(kernelSource.data(), kernelSource.size());
+		writePadding(file, header.metadataOffset_);
+		file.write(metadataText.data(), metadataText.size());
+		return file.good();
+	}
+
+	//Maps aPath and checks its header. On failure the file stays closed//
+	bool open(const std::string& aPath)
+	{
+		close();
+		if (!map_.open(aPath))
+			return false;
+
+		if (!isValid())
+		{
+			std::cout << "Model_File: " << aPath << " is not a version " << version_ << " binary model" << std::endl;
+			close();
+			return false;
+		}
+		header_ = (const Header*)map_.data();
+		return true;
+	}
+	void close()
+	{
+		map_.close();
+		header_ = nullptr;
+	}
+	bool isOpen() const
+	{
+		return header_ != nullptr;
+	}
+
+	uint32_t width() const
+	{
+		return header_->width_;
+	}
+	uint32_t height() const
+	{
+		return header_->height_;
+	}
+	uint32_t idBytes() const
+	{
+		return header_->idBytes_;
+	}
+	//Only valid for the matching idBytes()//
+	int32_t* idGrid32() const
+	{
+		return (int32_t*)(map_.data() + header_->idGridOffset_);
+	}
+	const int8_t* idGrid8() const
+	{
+		return (const int8_t*)(map_.data() + header_->idGridOffset_);
+	}
+	float* boundaryGrid() const
+	{
+		return (float*)(map_.data() + header_->boundaryGridOffset_);
+	}
+	std::string kernelSource() const
+	{
+		return std::string((const char*)map_.data() + header_->kernelOffset_, header_->kernelLength_);
+	}
+	//{"controllers": [...], "interface": ...} as in the source JSON, minus the first controller's physics_kernel//
+	std::string metadata() const
+	{
+		return std::string((const char*)map_.data() + header_->metadataOffset_, header_->metadataLength_);
+	}
+};
+
+#endif
@@ -4,6 +4,8 @@
 
 #include <iostream>
 
+#include "Program_Binary_Cache.hpp"
+
 struct OpenCL_Device
 {
 	uint32_t platform_id;
@@ -80,22 +82,14 @@ public:
 
 	void createKernelProgram(cl::Context& aContext, cl::Program& aKernelProgram, const std::string aSourcePath, const char options[])
 	{
-		//Read in program source - I'm going to go for reading from compiled object instead//
+		//Read in program source - The compiled object comes from Program_Binary_Cache when an earlier run saved one//
 		std::ifstream sourceFileName(aSourcePath.c_str());
 		std::string sourceFile(std::istreambuf_iterator<char>(sourceFileName), (std::istreambuf_iterator<char>()));
 
-		//Create program source object from std::string source code//
-		std::vector<std::string> programSources;
-		programSources.push_back(sourceFile);
-		cl::Program::Sources source(programSources);	//Apparently this takes a vector of strings as the program source.
-
-		//Create program from source code//
-		aKernelProgram = cl::Program(aContext, source, &errorStatus_);
+		//Create and build program//
+		errorStatus_ = Program_Binary_Cache::build(aContext, sourceFile, options != NULL ? options : "", aKernelProgram);
 		if (errorStatus_)
-			std::cout << "ERROR creating program from source. Status code: " << errorStatus_ << std::endl;
-
-		//Build program//
-		aKernelProgram.build(options);
+			std::cout << "ERROR building program from source. Status code: " << errorStatus_ << std::endl;
 	}
 	void createKernel(cl::Context& aContext, cl::Program& aKernelProgram, cl::Kernel& aKernel, std::string aKernelName)
 	{
@@ -0,0 +1,197 @@
+#ifndef PROGRAM_BINARY_CACHE_HPP
+#define PROGRAM_BINARY_CACHE_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#include <CL/cl2.hpp>
+
+//Compiled OpenCL programs kept on disk as CL_PROGRAM_BINARIES, so later runs skip the compiler.//
+//Files are named by hashes of the source, the build options and every device's name and driver version - An edited kernel or updated driver misses rather than loading a stale binary.//
+//A binary the driver rejects, or that fails to build, falls back to the source and is overwritten//
+class Program_Binary_Cache
+{
+private:
+	struct Header
+	{
+		char magic_[4];
+		uint32_t version_;
+		uint64_t sourceHash_;
+		uint64_t optionsHash_;
+		uint64_t deviceHash_;
+		uint32_t numDevices_;
+		uint32_t reserved_;
+	};
+	static const uint32_t version_ = 1;
+
+	static std::string& directory()
+	{
+		static std::string directory = "CL_Cache";
+		return directory;
+	}
+	static bool& isEnabled()
+	{
+		static bool isEnabled = true;
+		return isEnabled;
+	}
+
+	static Header makeHeader(const std::vector<cl::Device>& aDevices, const std::string& aSource, const std::string& aOptions)
+	{
+		std::string deviceDescription;
+		for (uint32_t i = 0; i != aDevices.size(); ++i)
+		{
+			cl::Platform platform(aDevices[i].getInfo<CL_DEVICE_PLATFORM>());
+			deviceDescription += aDevices[i].getInfo<CL_DEVICE_NAME>() + "\n" + aDevices[i].getInfo<CL_DEVICE_VERSION>() + "\n"
+				+ aDevices[i].getInfo<CL_DRIVER_VERSION>() + "\n" + platform.getInfo<CL_PLATFORM_VERSION>() + "\n";
+		}
+
+		Header header = {};
+		memcpy(header.magic_, "FCLB", 4);
+		header.version_ = version_;
+		header.sourceHash_ = hashString(aSource);
+		header.optionsHash_ = hashString(aOptions);
+		header.deviceHash_ = hashString(deviceDescription);
+		header.numDevices_ = aDevices.size();
+		return header;
+	}
+	static std::string cachePath(const Header& aHeader)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "%016llx_%016llx_%016llx.clbin", (unsigned long long)aHeader.sourceHash_, (unsigned long long)aHeader.optionsHash_, (unsigned long long)aHeader.deviceHash_);
+		return directory() + "/" + name;
+	}
+
+	//Creates and builds aProgram from the binary at aPath. False on any mismatch or driver error, leaving the caller to build from source//
+	static bool loadProgram(const cl::Context& aContext, const std::vector<cl::Device>& aDevices, const Header& aHeader, const std::string& aPath, const std::string& aOptions, cl::Program& aProgram)
+	{
+		std::ifstream file(aPath, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		Header header;
+		if (!file.read((char*)&header, sizeof(Header)) || memcmp(&header, &aHeader, sizeof(Header)) != 0)
+			return false;
+
+		cl::Program::Binaries binaries(aDevices.size());
+		for (uint32_t i = 0; i != aDevices.size(); ++i)
+		{
+			uint64_t size = 0;
+			if (!file.read((char*)&size, sizeof(size)) || size == 0)
+				return false;
+			binaries[i].resize(size);
+			if (!file.read((char*)binaries[i].data(), size))
+				return false;
+		}
+
+		cl_int status = CL_SUCCESS;
+		std::vector<cl_int> binaryStatus;
+		aProgram = cl::Program(aContext, aDevices, binaries, &binaryStatus, &status);
+		for (uint32_t i = 0; i != binaryStatus.size(); ++i)
+			status = status == CL_SUCCESS ? binaryStatus[i] : status;
+		if (status == CL_SUCCESS)
+			status = aProgram.build(aDevices, aOptions.c_str());
+		if (status != CL_SUCCESS)
+		{
+			std::cout << "Program_Binary_Cache: " << aPath << " was rejected by the driver, rebuilding from source. Status code: " << status << std::endl;
+			return false;
+		}
+		return true;
+	}
+	//Written beside its final name under a random suffix and renamed into place, so a concurrent instance never reads half a binary, and two//
+	//instances saving the same program never write into one temporary file//
+	static void saveProgram(const cl::Program& aProgram, const Header& aHeader, const std::string& aPath)
+	{
+		cl_int status = CL_SUCCESS;
+		std::vector<std::vector<unsigned char>> binaries = aProgram.getInfo<CL_PROGRAM_BINARIES>(&status);
+		if (status != CL_SUCCESS || binaries.size() != aHeader.numDevices_)
+			return;
+
+		std::error_code error;
+		std::filesystem::create_directories(directory(), error);
+		std::random_device random;
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), ".%08x%08x.tmp", (unsigned int)random(), (unsigned int)random());
+		std::string temporaryPath = aPath + suffix;
+		{
+			std::ofstream file(temporaryPath, std::ios::binary);
+			file.write((const char*)&aHeader, sizeof(Header));
+			for (uint32_t i = 0; i != binaries.size(); ++i)
+			{
+				uint64_t size = binaries[i].size();
+				file.write((const char*)&size, sizeof(size));
+				file.write((const char*)binaries[i].data(), size);
+			}
+			if (!file.good())
+			{
+				file.close();
+				std::filesystem::remove(temporaryPath, error);
+				return;
+			}
+		}
+		std::filesystem::rename(temporaryPath, aPath, error);
+		if (error)
+			std::filesystem::remove(temporaryPath, error);
+	}
+public:
+	//FNV-1a - Unlike std::hash it is the same on every run and platform, so it can name files//
+	static uint64_t hashString(const std::string& aString)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i != aString.size(); ++i)
+		{
+			hash ^= (unsigned char)aString[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	//Builds aSource with aOptions for every device in aContext, loading the cached binary when one matches and saving one when it doesn't.//
+	//Returns the OpenCL status of the build//
+	static cl_int build(const cl::Context& aContext, const std::string& aSource, const std::string& aOptions, cl::Program& aProgram)
+	{
+		std::vector<cl::Device> devices = aContext.getInfo<CL_CONTEXT_DEVICES>();
+		Header header = makeHeader(devices, aSource, aOptions);
+		std::string path = cachePath(header);
+		if (isEnabled() && loadProgram(aContext, devices, header, path, aOptions, aProgram))
+			return CL_SUCCESS;
+
+		std::vector<std::string> programSources;
+		programSources.push_back(aSource);
+		cl::Program::Sources source(programSources);
+
+		cl_int status = CL_SUCCESS;
+		aProgram = cl::Program(aContext, source, &status);
+		if (status == CL_SUCCESS)
+			status = aProgram.build(devices, aOptions.c_str());
+		if (status == CL_SUCCESS && isEnabled())
+			saveProgram(aProgram, header, path);
+		return status;
+	}
+
+	//Off builds every program from source and leaves the directory alone//
+	static void setEnabled(bool aIsEnabled)
+	{
+		isEnabled() = aIsEnabled;
+	}
+	static void setDirectory(const std::string& aDirectory)
+	{
+		directory() = aDirectory;
+	}
+	//Deletes every cached binary, e.g. after a driver change that kept its version string//
+	static void clear()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(directory(), error);
+	}
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+//Lock-free single producer, single consumer FIFO - One thread may only write, the other may only read//
+//Capacity is rounded up to a power of two so indices wrap with a mask. Positions count up forever and are only masked on access//
+template<typename T>
+class Ring_Buffer
+{
+private:
+	std::vector<T> buffer_;
+	uint32_t mask_;
+
+	//Kept on separate cache lines so producer and consumer don't invalidate each other's position//
+	alignas(64) std::atomic<uint32_t> writePosition_;
+	alignas(64) std::atomic<uint32_t> readPosition_;
+public:
+	Ring_Buffer(uint32_t aCapacity) :
+		writePosition_(0),
+		readPosition_(0)
+	{
+		uint32_t capacity = 1;
+		while (capacity < aCapacity)
+			capacity *= 2;
+		buffer_.resize(capacity);
+		mask_ = capacity - 1;
+	}
+
+	uint32_t capacity() const
+	{
+		return mask_ + 1;
+	}
+	//Elements ready to read. Exact from the consumer, a lower bound from the producer//
+	uint32_t available() const
+	{
+		return writePosition_.load(std::memory_order_acquire) - readPosition_.load(std::memory_order_acquire);
+	}
+	//Free slots. Exact from the producer, a lower bound from the consumer//
+	uint32_t space() const
+	{
+		return capacity() - available();
+	}
+
+	//Producer only - Writes all of aData or nothing//
+	bool push(const T* aData, uint32_t aCount)
+	{
+		const uint32_t write = writePosition_.load(std::memory_order_relaxed);
+		const uint32_t read = readPosition_.load(std::memory_order_acquire);
+		if (capacity() - (write - read) < aCount)
+			return false;
+
+		for (uint32_t i = 0; i != aCount; ++i)
+			buffer_[(write + i) & mask_] = aData[i];
+		writePosition_.store(write + aCount, std::memory_order_release);
+		return true;
+	}
+	//Consumer only - Reads up to aCount elements, returning how many were read//
+	uint32_t pop(T* aData, uint32_t aCount)
+	{
+		const uint32_t read = readPosition_.load(std::memory_order_relaxed);
+		const uint32_t write = writePosition_.load(std::memory_order_acquire);
+		const uint32_t count = write - read < aCount ? write - read : aCount;
+
+		for (uint32_t i = 0; i != count; ++i)
+			aData[i] = buffer_[(read + i) & mask_];
+		readPosition_.store(read + count, std::memory_order_release);
+		return count;
+	}
+	//Only safe while neither side is running//
+	void clear()
+	{
+		writePosition_.store(0);
+		readPosition_.store(0);
+	}
+};
+
+#endif
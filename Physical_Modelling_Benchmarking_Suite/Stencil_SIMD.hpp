@@ -0,0 +1,18 @@
+#ifndef STENCIL_SIMD_HPP
+#define STENCIL_SIMD_HPP
+
+#include <stdint.h>
+
+#include "FDTD_Materials.hpp"
+
+//Hand vectorised span updates for FDTD_CPU. Stencil_SIMD.inl is built once per instruction set (Stencil_SIMD_*.cpp) and libsimdpp picks the widest one the host supports on first call//
+//Each call updates aCount contiguous cells of one row, starting at grid index aOffset, in a grid aWidth cells wide. aOpenGrid holds the weight of each cell as a//
+//neighbour, (1-boundaryGrid) or 1. The y+1 neighbour is weighted from aRowAfterOpenGrid instead, aOpenGrid itself unless the kernel mirrors its rightIdx//
+void simdMembraneSpan(const float* aGrid, const float* aPreviousGrid, float* aNextGrid, const float* aOpenGrid, const float* aRowAfterOpenGrid, uint32_t aWidth, uint32_t aOffset, uint32_t aCount, const Material_Coefficients* aCoefficients);
+void simdStringSpan(const float* aGrid, const float* aPreviousGrid, float* aNextGrid, const float* aOpenGrid, const float* aRowAfterOpenGrid, uint32_t aWidth, uint32_t aOffset, uint32_t aCount, const Material_Coefficients* aCoefficients);
+void simdPlateSpan(const float* aGrid, const float* aPreviousGrid, float* aNextGrid, const float* aOpenGrid, const float* aRowAfterOpenGrid, uint32_t aWidth, uint32_t aOffset, uint32_t aCount, const Material_Coefficients* aCoefficients);
+
+//Name of the instruction set the dispatcher selected (SSE2, AVX2 or AVX512F)//
+const char* simdArchitecture();
+
+#endif
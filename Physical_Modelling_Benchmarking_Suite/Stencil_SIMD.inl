@@ -0,0 +1,114 @@
+//Shared body of Stencil_SIMD_SSE2.cpp, Stencil_SIMD_AVX2.cpp and Stencil_SIMD_AVX512F.cpp//
+//Each translation unit sets SIMDPP_ARCH_PP_LIST to its own instruction set and must be compiled with the matching /arch flag//
+#define SIMDPP_DISPATCH_ARCH1 SIMDPP_ARCH_X86_SSE2
+#define SIMDPP_DISPATCH_ARCH2 SIMDPP_ARCH_X86_AVX2
+#define SIMDPP_DISPATCH_ARCH3 SIMDPP_ARCH_X86_AVX512F
+#define SIMDPP_USER_ARCH_INFO ::simdpp::get_arch_raw_cpuid()
+
+#include <simdpp/simd.h>
+#include <simdpp/dispatch/get_arch_raw_cpuid.h>
+
+#include "Stencil_SIMD.hpp"
+
+namespace SIMDPP_ARCH_NAMESPACE {
+
+typedef simdpp::float32<SIMDPP_FAST_FLOAT32_SIZE> Vector;
+static const uint32_t vectorSize = SIMDPP_FAST_FLOAT32_SIZE;
+
+//Neighbours are weighted by their open flag, the same as (1-boundaryGrid[...]) in the model's kernel//
+static inline Vector weighted(const float* aGrid, const float* aOpenGrid, uint32_t aIdx)
+{
+	Vector value = simdpp::load_u(aGrid + aIdx);
+	Vector open = simdpp::load_u(aOpenGrid + aIdx);
+	return value * open;
+}
+static inline float weightedScalar(const float* aGrid, const float* aOpenGrid, uint32_t aIdx)
+{
+	return aGrid[aIdx] * aOpenGrid[aIdx];
+}
+
+template<MaterialType Type>
+static void updateSpan(const float* aGrid, const float* aPreviousGrid, float* aNextGrid, const float* aOpenGrid, const float* aRowAfterOpenGrid, uint32_t aWidth, uint32_t aOffset, uint32_t aCount, const Material_Coefficients* aCoefficients)
+{
+	const Material_Coefficients& c = *aCoefficients;
+	const Vector two = simdpp::splat(2.0f);
+	const Vector previous = simdpp::splat(c.previous);
+	const Vector centre = simdpp::splat(c.centre);
+	const Vector adjacent = simdpp::splat(c.adjacent);
+	const Vector diagonal = simdpp::splat(c.diagonal);
+	const Vector distant = simdpp::splat(c.distant);
+	const Vector normalise = simdpp::splat(c.normalise);
+	const uint32_t w = aWidth;
+	const uint32_t end = aOffset + aCount;
+
+	uint32_t idx = aOffset;
+	for (; idx + vectorSize <= end; idx += vectorSize)
+	{
+		Vector u = simdpp::load_u(aGrid + idx);
+		Vector uM1 = simdpp::load_u(aPreviousGrid + idx);
+		Vector sumAdjacent = weighted(aGrid, aOpenGrid, idx - w) + weighted(aGrid, aRowAfterOpenGrid, idx + w);
+		if (Type != MATERIAL_STRING)
+			sumAdjacent = sumAdjacent + weighted(aGrid, aOpenGrid, idx - 1) + weighted(aGrid, aOpenGrid, idx + 1);
+
+		Vector next = two * u + previous * uM1 + centre * u + adjacent * sumAdjacent;
+		if (Type == MATERIAL_PLATE)
+		{
+			Vector sumDiagonal = weighted(aGrid, aOpenGrid, idx - w - 1) + weighted(aGrid, aOpenGrid, idx - w + 1)
+				+ weighted(aGrid, aOpenGrid, idx + w - 1) + weighted(aGrid, aOpenGrid, idx + w + 1);
+			Vector sumDistant = weighted(aGrid, aOpenGrid, idx - 2 * w) + weighted(aGrid, aOpenGrid, idx + 2 * w)
+				+ weighted(aGrid, aOpenGrid, idx - 2) + weighted(aGrid, aOpenGrid, idx + 2);
+			next = next + diagonal * sumDiagonal + distant * sumDistant;
+		}
+		simdpp::store_u(aNextGrid + idx, Vector(next * normalise));
+	}
+
+	//Remainder narrower than one vector//
+	for (; idx < end; ++idx)
+	{
+		float sumAdjacent = weightedScalar(aGrid, aOpenGrid, idx - w) + weightedScalar(aGrid, aRowAfterOpenGrid, idx + w);
+		float sumDiagonal = 0.0;
+		float sumDistant = 0.0;
+		if (Type != MATERIAL_STRING)
+			sumAdjacent += weightedScalar(aGrid, aOpenGrid, idx - 1) + weightedScalar(aGrid, aOpenGrid, idx + 1);
+		if (Type == MATERIAL_PLATE)
+		{
+			sumDiagonal = weightedScalar(aGrid, aOpenGrid, idx - w - 1) + weightedScalar(aGrid, aOpenGrid, idx - w + 1)
+				+ weightedScalar(aGrid, aOpenGrid, idx + w - 1) + weightedScalar(aGrid, aOpenGrid, idx + w + 1);
+			sumDistant = weightedScalar(aGrid, aOpenGrid, idx - 2 * w) + weightedScalar(aGrid, aOpenGrid, idx + 2 * w)
+				+ weightedScalar(aGrid, aOpenGrid, idx - 2) + weightedScalar(aGrid, aOpenGrid, idx + 2);
+		}
+		aNextGrid[idx] = (2.0f * aGrid[idx] + c.previous * aPreviousGrid[idx] + c.centre * aGrid[idx]
+			+ c.adjacent * sumAdjacent + c.diagonal * sumDiagonal + c.distant * sumDistant) * c.normalise;
+	}
+}
+
+void simdMembraneSpan(const float* aGrid, const float* aPreviousGrid, float* aNextGrid, const float* aOpenGrid, const float* aRowAfterOpenGrid, uint32_t aWidth, uint32_t aOffset, uint32_t aCount, const Material_Coefficients* aCoefficients)
+{
+	updateSpan<MATERIAL_MEMBRANE>(aGrid, aPreviousGrid, aNextGrid, aOpenGrid, aRowAfterOpenGrid, aWidth, aOffset, aCount, aCoefficients);
+}
+void simdStringSpan(const float* aGrid, const float* aPreviousGrid, float* aNextGrid, const float* aOpenGrid, const float* aRowAfterOpenGrid, uint32_t aWidth, uint32_t aOffset, uint32_t aCount, const Material_Coefficients* aCoefficients)
+{
+	updateSpan<MATERIAL_STRING>(aGrid, aPreviousGrid, aNextGrid, aOpenGrid, aRowAfterOpenGrid, aWidth, aOffset, aCount, aCoefficients);
+}
+void simdPlateSpan(const float* aGrid, const float* aPreviousGrid, float* aNextGrid, const float* aOpenGrid, const float* aRowAfterOpenGrid, uint32_t aWidth, uint32_t aOffset, uint32_t aCount, const Material_Coefficients* aCoefficients)
+{
+	updateSpan<MATERIAL_PLATE>(aGrid, aPreviousGrid, aNextGrid, aOpenGrid, aRowAfterOpenGrid, aWidth, aOffset, aCount, aCoefficients);
+}
+
+const char* simdArchitecture()
+{
+#if SIMDPP_USE_AVX512F
+	return "AVX512F";
+#elif SIMDPP_USE_AVX2
+	return "AVX2";
+#else
+	return "SSE2";
+#endif
+}
+
+}
+
+SIMDPP_MAKE_DISPATCHER((void)(simdMembraneSpan)((const float*) aGrid, (const float*) aPreviousGrid, (float*) aNextGrid, (const float*) aOpenGrid, (const float*) aRowAfterOpenGrid, (uint32_t) aWidth, (uint32_t) aOffset, (uint32_t) aCount, (const Material_Coefficients*) aCoefficients))
+SIMDPP_MAKE_DISPATCHER((void)(simdStringSpan)((const float*) aGrid, (const float*) aPreviousGrid, (float*) aNextGrid, (const float*) aOpenGrid, (const float*) aRowAfterOpenGrid, (uint32_t) aWidth, (uint32_t) aOffset, (uint32_t) aCount, (const Material_Coefficients*) aCoefficients))
+SIMDPP_MAKE_DISPATCHER((void)(simdPlateSpan)((const float*) aGrid, (const float*) aPreviousGrid, (float*) aNextGrid, (const float*) aOpenGrid, (const float*) aRowAfterOpenGrid, (uint32_t) aWidth, (uint32_t) aOffset, (uint32_t) aCount, (const Material_Coefficients*) aCoefficients))
+SIMDPP_MAKE_DISPATCHER((const char*)(simdArchitecture)())
@@ -0,0 +1,4 @@
+//AVX2 build of Stencil_SIMD.inl - Compiled with /arch:AVX2//
+#define SIMDPP_ARCH_PP_LIST SIMDPP_ARCH_X86_AVX2
+
+#include "Stencil_SIMD.inl"
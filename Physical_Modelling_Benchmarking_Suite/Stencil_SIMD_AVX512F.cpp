@@ -0,0 +1,4 @@
+//AVX-512 build of Stencil_SIMD.inl - Compiled with /arch:AVX512//
+#define SIMDPP_ARCH_PP_LIST SIMDPP_ARCH_X86_AVX512F
+
+#include "Stencil_SIMD.inl"
@@ -0,0 +1,5 @@
+//Baseline build of Stencil_SIMD.inl - Also emits the runtime dispatchers//
+#define SIMDPP_ARCH_PP_LIST SIMDPP_ARCH_X86_SSE2
+#define SIMDPP_EMIT_DISPATCHER 1
+
+#include "Stencil_SIMD.inl"
@@ -0,0 +1,134 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Persistent pool for fork-join loops issued once per sample - Workers spin briefly between dispatches and only then sleep//
+class Thread_Pool
+{
+private:
+	static const uint32_t spinLimit_ = 20000;
+
+	std::vector<std::thread> workers_;
+	std::function<void(uint32_t, uint32_t)> task_;
+	uint32_t taskBegin_ = 0;
+	uint32_t taskEnd_ = 0;
+	uint32_t numChunks_ = 0;
+
+	std::atomic<uint32_t> generation_;
+	std::atomic<uint32_t> pending_;
+	std::atomic<uint32_t> sleepers_;
+	std::atomic<bool> isRunning_;
+	std::mutex mutex_;
+	std::condition_variable wakeCondition_;
+
+	void runChunk(uint32_t aChunk)
+	{
+		if (aChunk >= numChunks_)
+			return;
+
+		//Split range evenly, spreading the remainder over the first chunks//
+		uint32_t length = taskEnd_ - taskBegin_;
+		uint32_t chunkSize = length / numChunks_;
+		uint32_t remainder = length % numChunks_;
+		uint32_t begin = taskBegin_ + aChunk * chunkSize + (aChunk < remainder ? aChunk : remainder);
+		uint32_t end = begin + chunkSize + (aChunk < remainder ? 1 : 0);
+		task_(begin, end);
+	}
+	void waitForWork(uint32_t& aSeenGeneration)
+	{
+		for (uint32_t i = 0; i != spinLimit_; ++i)
+		{
+			if (generation_.load(std::memory_order_acquire) != aSeenGeneration)
+			{
+				aSeenGeneration = generation_.load(std::memory_order_acquire);
+				return;
+			}
+			std::this_thread::yield();
+		}
+
+		//No work arrived while spinning - Block until the next dispatch//
+		std::unique_lock<std::mutex> lock(mutex_);
+		++sleepers_;
+		wakeCondition_.wait(lock, [&] { return generation_.load() != aSeenGeneration; });
+		--sleepers_;
+		aSeenGeneration = generation_.load();
+	}
+	void workerLoop(uint32_t aChunk)
+	{
+		uint32_t seenGeneration = 0;
+		while (true)
+		{
+			waitForWork(seenGeneration);
+			if (!isRunning_.load())
+				return;
+
+			runChunk(aChunk);
+			pending_.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+public:
+	Thread_Pool(uint32_t aNumThreads) :
+		generation_(0),
+		pending_(0),
+		sleepers_(0),
+		isRunning_(true)
+	{
+		//Calling thread always takes chunk 0, so only spawn the remaining workers//
+		for (uint32_t i = 1; i < aNumThreads; ++i)
+			workers_.push_back(std::thread(&Thread_Pool::workerLoop, this, i));
+	}
+	~Thread_Pool()
+	{
+		isRunning_.store(false);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			generation_.fetch_add(1);
+		}
+		wakeCondition_.notify_all();
+
+		for (uint32_t i = 0; i != workers_.size(); ++i)
+			workers_[i].join();
+	}
+
+	uint32_t size() const
+	{
+		return workers_.size() + 1;
+	}
+
+	//Runs aTask over [aBegin, aEnd) split into at most aNumChunks contiguous ranges. Returns once every range is done//
+	void parallelFor(uint32_t aBegin, uint32_t aEnd, uint32_t aNumChunks, const std::function<void(uint32_t, uint32_t)>& aTask)
+	{
+		uint32_t numChunks = aNumChunks < size() ? aNumChunks : size();
+		if (numChunks <= 1 || workers_.empty())
+		{
+			aTask(aBegin, aEnd);
+			return;
+		}
+
+		task_ = aTask;
+		taskBegin_ = aBegin;
+		taskEnd_ = aEnd;
+		numChunks_ = numChunks;
+		pending_.store(workers_.size(), std::memory_order_relaxed);
+
+		generation_.fetch_add(1);
+		if (sleepers_.load() != 0)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			wakeCondition_.notify_all();
+		}
+
+		runChunk(0);
+		while (pending_.load(std::memory_order_acquire) != 0)
+			std::this_thread::yield();
+	}
+};
+
+#endif
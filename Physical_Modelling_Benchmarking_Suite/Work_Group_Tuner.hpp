@@ -0,0 +1,147 @@
+#ifndef WORK_GROUP_TUNER_HPP
+#define WORK_GROUP_TUNER_HPP
+
+#include <stdint.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define CL_HPP_TARGET_OPENCL_VERSION 120
+#define CL_HPP_MINIMUM_OPENCL_VERSION 120
+#include <CL/cl2.hpp>
+
+#include "third_party/json.hpp"
+#include "Program_Binary_Cache.hpp"
+
+//One local size tried by Work_Group_Tuner::search(). timePerStep is in ms, negative when the launch was refused//
+struct Work_Group_Timing
+{
+	size_t x = 1;
+	size_t y = 1;
+	double timePerStep = -1.0;
+	cl_int status = CL_SUCCESS;
+};
+
+//Times a 2D kernel over every legal local size and keeps the fastest, per device, kernel source and grid size, in a JSON file beside the program binaries.//
+//Legal sizes divide the grid, fit CL_KERNEL_WORK_GROUP_SIZE and CL_DEVICE_MAX_WORK_ITEM_SIZES, and are multiples of CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE where any are//
+class Work_Group_Tuner
+{
+private:
+	static std::string& path()
+	{
+		static std::string path = "CL_Cache/work_group_sizes.json";
+		return path;
+	}
+	//Loaded on first use and written back on every store(), so each process reads the file once//
+	static nlohmann::json& choices()
+	{
+		static nlohmann::json choices;
+		static bool isLoaded = false;
+		if (!isLoaded)
+		{
+			std::ifstream file(path());
+			if (file.is_open())
+				choices = nlohmann::json::parse(file, nullptr, false);
+			if (!choices.is_object())
+				choices = nlohmann::json::object();
+			isLoaded = true;
+		}
+		return choices;
+	}
+public:
+	//Names a choice by the device and driver, the kernel source and the grid it was timed on//
+	static std::string makeKey(const cl::Device& aDevice, const std::string& aKernelSource, size_t aWidth, size_t aHeight)
+	{
+		char hashes[40];
+		snprintf(hashes, sizeof(hashes), "%016llx_%016llx", (unsigned long long)Program_Binary_Cache::hashString(aDevice.getInfo<CL_DEVICE_NAME>() + "\n" + aDevice.getInfo<CL_DRIVER_VERSION>()),
+			(unsigned long long)Program_Binary_Cache::hashString(aKernelSource));
+		return std::string(hashes) + "_" + std::to_string(aWidth) + "x" + std::to_string(aHeight);
+	}
+	static bool lookup(const std::string& aKey, cl::NDRange& aLocal)
+	{
+		nlohmann::json::iterator choice = choices().find(aKey);
+		if (choice == choices().end() || !choice->is_array() || choice->size() != 2)
+			return false;
+
+		aLocal = cl::NDRange((*choice)[0].get<size_t>(), (*choice)[1].get<size_t>());
+		return true;
+	}
+	static void store(const std::string& aKey, const cl::NDRange& aLocal)
+	{
+		choices()[aKey] = { aLocal.get()[0], aLocal.get()[1] };
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path()).parent_path(), error);
+		std::ofstream file(path());
+		file << choices().dump(1, '\t');
+	}
+	static void setPath(const std::string& aPath)
+	{
+		path() = aPath;
+	}
+
+	//Power of two local sizes that are legal for aKernel on aDevice over an aWidth x aHeight grid//
+	static std::vector<Work_Group_Timing> candidates(const cl::Device& aDevice, const cl::Kernel& aKernel, size_t aWidth, size_t aHeight)
+	{
+		size_t maxGroupSize = aKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(aDevice);
+		size_t multiple = aKernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(aDevice);
+		std::vector<size_t> maxItemSizes = aDevice.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+		multiple = multiple == 0 || multiple > maxGroupSize ? 1 : multiple;
+
+		std::vector<Work_Group_Timing> sizes;
+		for (size_t x = 1; x <= aWidth && x <= maxItemSizes[0]; x *= 2)
+		{
+			for (size_t y = 1; y <= aHeight && y <= maxItemSizes[1]; y *= 2)
+			{
+				if (x * y <= maxGroupSize && (x * y) % multiple == 0 && aWidth % x == 0 && aHeight % y == 0)
+				{
+					Work_Group_Timing size;
+					size.x = x;
+					size.y = y;
+					sizes.push_back(size);
+				}
+			}
+		}
+		return sizes;
+	}
+	//Times aNumSteps launches of aKernel, its arguments already set, for each candidate. aQueue must have profiling enabled.//
+	//The launches write aKernel's output as usual, so callers reset whatever state it changes//
+	static std::vector<Work_Group_Timing> search(cl::CommandQueue& aQueue, const cl::Device& aDevice, cl::Kernel& aKernel, const cl::NDRange& aGlobal, uint32_t aNumSteps = 64)
+	{
+		std::vector<Work_Group_Timing> sizes = candidates(aDevice, aKernel, aGlobal.get()[0], aGlobal.get()[1]);
+		for (uint32_t i = 0; i != sizes.size(); ++i)
+		{
+			cl::NDRange local(sizes[i].x, sizes[i].y);
+			cl::Event first;
+			cl::Event last;
+
+			//One untimed launch first, so the search doesn't charge the first size for warming the device//
+			sizes[i].status = aQueue.enqueueNDRangeKernel(aKernel, cl::NullRange, aGlobal, local);
+			for (uint32_t j = 0; sizes[i].status == CL_SUCCESS && j != aNumSteps; ++j)
+				sizes[i].status = aQueue.enqueueNDRangeKernel(aKernel, cl::NullRange, aGlobal, local, NULL, j == 0 ? &first : (j == aNumSteps - 1 ? &last : NULL));
+			aQueue.finish();
+			if (sizes[i].status != CL_SUCCESS || aNumSteps < 2)
+				continue;
+
+			cl_ulong start = first.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+			cl_ulong end = last.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+			sizes[i].timePerStep = (end - start) / 1000000.0 / aNumSteps;
+		}
+		return sizes;
+	}
+	//The fastest of aSizes, or aFallback when none ran//
+	static cl::NDRange fastest(const std::vector<Work_Group_Timing>& aSizes, const cl::NDRange& aFallback)
+	{
+		const Work_Group_Timing* best = nullptr;
+		for (uint32_t i = 0; i != aSizes.size(); ++i)
+		{
+			if (aSizes[i].timePerStep >= 0.0 && (best == nullptr || aSizes[i].timePerStep < best->timePerStep))
+				best = &aSizes[i];
+		}
+		return best != nullptr ? cl::NDRange(best->x, best->y) : aFallback;
+	}
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "GPU_Benchmark_OpenCL.hpp"
@@ -8,6 +10,49 @@ int main(int argc, char** argv)
 
 	//Check OpenCL support and device availability//
 	bool isOpenCl = GPU_Benchmark_OpenCL::openclCompatible();
+
+	//"--stream" plays the single model through the default audio device instead of benchmarking. "--null-audio" swaps in the null device for headless runs//
+	//"--histograms" writes each timer's raw latency histogram next to its log. "--calibrate" reports the timers' own overhead first//
+	//"--convert-models" writes a binary .fdtm beside every JSON model, which createModel() then maps instead of parsing//
+	//"--no-program-cache" builds every OpenCL program from source. "--clear-program-cache" deletes the binaries earlier runs saved to CL_Cache//
+	//"--tune-work-groups" searches each device's work group sizes before its benchmarks, keeping the fastest in CL_Cache for later runs//
+	bool isStreaming = false;
+	bool isNullAudio = false;
+	bool isTuningWorkGroups = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument(argv[i]);
+		isStreaming = isStreaming || argument == "--stream";
+		isNullAudio = isNullAudio || argument == "--null-audio";
+		isTuningWorkGroups = isTuningWorkGroups || argument == "--tune-work-groups";
+		if (argument == "--histograms")
+			Benchmarker::setHistogramDump(true);
+		if (argument == "--convert-models")
+			Model_File::convertDirectory("resources/kernels");
+		if (argument == "--no-program-cache")
+			Program_Binary_Cache::setEnabled(false);
+		if (argument == "--clear-program-cache")
+			Program_Binary_Cache::clear();
+		if (argument == "--calibrate")
+		{
+			Benchmarker calibrationBenchmarker("CL_Logs/timer_calibration.csv", { "Test_Name", "Total_Time", "Average_Time", "Max_Time", "Min_Time", "Max_Difference", "Average_Difference" });
+			calibrationBenchmarker.calibrate();
+		}
+	}
+	if (isStreaming)
+	{
+		std::unique_ptr<GPU_Benchmark_OpenCL> streamBenchmark;
+		if (isOpenCl)
+		{
+			std::vector<OpenCL_Device> clDevices = OpenCL_Wrapper::getOpenclDevices();
+			streamBenchmark.reset(new GPU_Benchmark_OpenCL(clDevices[0].platform_name, clDevices[0].platform_id, clDevices[0].device_id));
+		}
+		else
+			streamBenchmark.reset(new GPU_Benchmark_OpenCL("CPU", 0, 0, Implementation::CPU_SIMD));
+
+		streamBenchmark->runStreamingTest(44100, 128, 4, 5.0, isNullAudio);
+		return 0;
+	}
 	if (isOpenCl)
 	{
 		std::vector<OpenCL_Device> clDevices = OpenCL_Wrapper::getOpenclDevices();
@@ -23,12 +68,20 @@ int main(int argc, char** argv)
 
 			//clBenchmark.cl_mappingmemory(100);
 			//clBenchmark.runGeneralBenchmarks(86, false);
+			if (isTuningWorkGroups)
+				clBenchmark.runWorkGroupTuning();
 			clBenchmark.runRealTimeBenchmarks(44100, true);
 		}
 	}
 	else
 		std::cout << "OpenCL device or support not present to benchmark OpenCL." << std::endl;
 
+	//Vectorised host engine, logged alongside the OpenCL devices//
+	std::cout << "Beginning CPU SIMD benchmarking" << std::endl << std::endl;
+	GPU_Benchmark_OpenCL simdBenchmark("CPU", 0, 0, Implementation::CPU_SIMD);
+	simdBenchmark.runRealTimeBenchmarks(44100, true);
+	simdBenchmark.runComplexRealTimeBenchmarks(44100, true);
+
 	char haltc;
 	std::cin >> haltc;
 }
\ No newline at end of file
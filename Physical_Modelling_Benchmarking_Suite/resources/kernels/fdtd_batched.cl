@@ -0,0 +1,52 @@
+float materialUpdate(__global float* current, __global float* previous, __global float* boundaryGrid, int centreIdx, int width, int type, __global float* c)
+{
+	float t1x0y0;
+	MATERIAL_STENCIL(float, t1x0y0, current[centreIdx], previous[centreIdx], type, width, c, OPEN_NEIGHBOUR);
+	return t1x0y0;
+}
+
+//Batched fdtdKernel - Dimension 2 of the NDRange is the voice. Every voice has its own three levels in modelGrid, [voice][level][cell], its own positions//
+//and its own coefficient table, [voice][id], but all share idGrid and boundaryGrid. Samples are interleaved, [idxSample * numVoices + voice]//
+__kernel
+void fdtdBatchedKernel(__global int* idGrid, __global float* modelGrid, __global float* boundaryGrid, int idxRotate, int idxSample, __global float* inputs, __global float* outputs, __global int* inputPositions, __global int* outputPositions, __global int* materialTypes, __global float* materialCoefficients, int numMaterials, int radius, int width, int height)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int voice = get_global_id(2);
+	int numVoices = get_global_size(2);
+	if (x >= width || y >= height)
+		return;
+
+	int gridSize = width * height;
+	__global float* voiceGrid = modelGrid + voice * 3 * gridSize;
+	__global float* current = voiceGrid + gridSize * rem(idxRotate, 3);
+	__global float* previous = voiceGrid + gridSize * rem(idxRotate - 1, 3);
+	__global float* next = voiceGrid + gridSize * rem(idxRotate + 1, 3);
+
+	int centreIdx = y * width + x;
+	if (centreIdx == outputPositions[voice])
+		outputs[idxSample * numVoices + voice] = current[centreIdx];
+
+	int id = idGrid[centreIdx];
+	int type = id > 0 && id < numMaterials ? materialTypes[id] : 0;
+
+	float t1x0y0 = 0.0f;
+	if (type != 0 && x >= radius && x < width - radius && y >= radius && y < height - radius)
+		t1x0y0 = materialUpdate(current, previous, boundaryGrid, centreIdx, width, type, materialCoefficients + (voice * numMaterials + id) * NUM_COEFFICIENTS);
+
+	if (centreIdx == inputPositions[voice])
+		t1x0y0 += inputs[idxSample * numVoices + voice];
+
+	next[centreIdx] = t1x0y0;
+}
+
+//Couples regions after fdtdBatchedKernel's step - One work-item per voice, each applying the (source, destination) pairs to its own levels in turn//
+__kernel
+void fdtdBatchedConnections(__global float* modelGrid, int idxRotate, int gridSize, int numConnections, __global int* connections)
+{
+	__global float* voiceGrid = modelGrid + get_global_id(0) * 3 * gridSize;
+	__global float* current = voiceGrid + gridSize * rem(idxRotate, 3);
+	__global float* next = voiceGrid + gridSize * rem(idxRotate + 1, 3);
+	for (int i = 0; i + 1 < numConnections; i += 2)
+		next[connections[i + 1]] += current[connections[i]];
+}
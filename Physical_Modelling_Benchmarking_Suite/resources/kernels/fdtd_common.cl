@@ -0,0 +1,58 @@
+//Shared by every kernel FDTD_Accelerated builds from resources/kernels. createKernelFromFile() puts this file in front of each source, so the kernels//
+//can't drift apart and an edit here changes every source Program_Binary_Cache hashes//
+int rem(int x, int y)
+{
+    return (x % y + y) % y;
+}
+
+//Material types, matching MaterialType in FDTD_Materials.hpp//
+#define MATERIAL_MEMBRANE 1
+#define MATERIAL_STRING 2
+#define MATERIAL_PLATE 3
+
+//Folded coefficients per material id, matching Material_Coefficients in FDTD_Materials.hpp//
+#define COEFFICIENT_PREVIOUS 0
+#define COEFFICIENT_CENTRE 1
+#define COEFFICIENT_ADJACENT 2
+#define COEFFICIENT_DIAGONAL 3
+#define COEFFICIENT_DISTANT 4
+#define COEFFICIENT_NORMALISE 5
+#define NUM_COEFFICIENTS 6
+
+//Neighbours of the stencil. Bits of the pitched kernel's neighbour masks, set where that neighbour's boundary weight is 1. N is the row before, W the//
+//cell before - Order matches neighbourOffsets in FDTD_Accelerated.hpp//
+#define NEIGHBOUR_N 0
+#define NEIGHBOUR_S 1
+#define NEIGHBOUR_W 2
+#define NEIGHBOUR_E 3
+#define NEIGHBOUR_NW 4
+#define NEIGHBOUR_NE 5
+#define NEIGHBOUR_SW 6
+#define NEIGHBOUR_SE 7
+#define NEIGHBOUR_NN 8
+#define NEIGHBOUR_SS 9
+#define NEIGHBOUR_WW 10
+#define NEIGHBOUR_EE 11
+
+//A level and boundary grid laid out alike, the neighbour offset cells from centreIdx weighted by how open it is//
+#define OPEN_NEIGHBOUR(bit, offset) (current[centreIdx + (offset)] * (1 - boundaryGrid[centreIdx + (offset)]))
+
+//The membrane, string and plate update of every material table kernel, summed in one order so they all round alike. Sets t1x0y0, of type T, to the//
+//next level of a cell at t0x0y0 now and previous0 before, with row stride w, MaterialType type and NUM_COEFFICIENTS folded coefficients c.//
+//NEIGHBOUR(bit, offset) is the including kernel's weighted neighbour, bit naming it for kernels reading masks//
+#define MATERIAL_STENCIL(T, t1x0y0, t0x0y0, previous0, type, w, c, NEIGHBOUR) \
+	do \
+	{ \
+		T adjacent = NEIGHBOUR(NEIGHBOUR_N, -(w)) + NEIGHBOUR(NEIGHBOUR_S, (w)); \
+		if ((type) != MATERIAL_STRING) \
+			adjacent += NEIGHBOUR(NEIGHBOUR_W, -1) + NEIGHBOUR(NEIGHBOUR_E, 1); \
+		t1x0y0 = 2 * (t0x0y0) + (c)[COEFFICIENT_PREVIOUS] * (previous0) + (c)[COEFFICIENT_CENTRE] * (t0x0y0) + (c)[COEFFICIENT_ADJACENT] * adjacent; \
+		if ((type) == MATERIAL_PLATE) \
+		{ \
+			T diagonal = NEIGHBOUR(NEIGHBOUR_NW, -(w) - 1) + NEIGHBOUR(NEIGHBOUR_NE, -(w) + 1) + NEIGHBOUR(NEIGHBOUR_SW, (w) - 1) + NEIGHBOUR(NEIGHBOUR_SE, (w) + 1); \
+			T distant = NEIGHBOUR(NEIGHBOUR_NN, -2 * (w)) + NEIGHBOUR(NEIGHBOUR_SS, 2 * (w)) + NEIGHBOUR(NEIGHBOUR_WW, -2) + NEIGHBOUR(NEIGHBOUR_EE, 2); \
+			t1x0y0 += (c)[COEFFICIENT_DIAGONAL] * diagonal + (c)[COEFFICIENT_DISTANT] * distant; \
+		} \
+		t1x0y0 *= (c)[COEFFICIENT_NORMALISE]; \
+	} while (0)
+
@@ -0,0 +1,46 @@
+//Built once per material type with -DMATERIAL_TYPE=n, so each launch runs a single update path//
+#ifndef MATERIAL_TYPE
+#define MATERIAL_TYPE MATERIAL_MEMBRANE
+#endif
+
+//One material's update over its own cells, cells[firstCell] to cells[firstCell + numCells - 1]. Models may supply their own fdtdMaterialKernel per controller with this signature//
+__kernel
+void fdtdMaterialKernel(__global float* modelGrid, __global float* boundaryGrid, int idxRotate, int width, int height, __global int* cells, int firstCell, int numCells, __global float* materialCoefficients, int id)
+{
+	int cellIdx = get_global_id(0);
+	if (cellIdx >= numCells)
+		return;
+
+	int gridSize = width * height;
+	__global float* current = modelGrid + gridSize * rem(idxRotate, 3);
+	__global float* previous = modelGrid + gridSize * rem(idxRotate - 1, 3);
+	__global float* next = modelGrid + gridSize * rem(idxRotate + 1, 3);
+	__global float* c = materialCoefficients + id * NUM_COEFFICIENTS;
+
+	//MATERIAL_TYPE is a constant, so the stencil's type branches fold away//
+	int centreIdx = cells[firstCell + cellIdx];
+	float t1x0y0;
+	MATERIAL_STENCIL(float, t1x0y0, current[centreIdx], previous[centreIdx], MATERIAL_TYPE, width, c, OPEN_NEIGHBOUR);
+	next[centreIdx] = t1x0y0;
+}
+
+//Lightweight pass after every material's launch for the step - One work-item reads the listener, clears the cells no material updates but the pass writes,//
+//then adds the excitation and couples regions. connections holds (source, destination) pairs, applied serially as destinations may repeat//
+__kernel
+void fdtdCouplingKernel(__global float* modelGrid, int idxRotate, int idxSample, int gridSize, __global float* input, __global float* output, int inputPosition, int outputPosition, __global int* clearCells, int numClearCells, __global int* connections, int numConnections)
+{
+	__global float* current = modelGrid + gridSize * rem(idxRotate, 3);
+	__global float* next = modelGrid + gridSize * rem(idxRotate + 1, 3);
+
+	if (outputPosition >= 0 && outputPosition < gridSize)
+		output[idxSample] = current[outputPosition];
+
+	for (int i = 0; i != numClearCells; ++i)
+		next[clearCells[i]] = 0.0f;
+
+	if (inputPosition >= 0 && inputPosition < gridSize)
+		next[inputPosition] += input[idxSample];
+
+	for (int i = 0; i + 1 < numConnections; i += 2)
+		next[connections[i + 1]] += current[connections[i]];
+}
@@ -0,0 +1,94 @@
+//Built with -DRESIDENT_LEVELS when two grids fit in local memory. Otherwise the levels stay in modelGrid and rotate exactly as fdtdKernel's do//
+#ifdef RESIDENT_LEVELS
+#define LEVEL __local
+#else
+#define LEVEL __global
+#endif
+
+float materialUpdate(LEVEL float* current, LEVEL float* previous, __global float* boundaryGrid, int centreIdx, int width, int type, __global float* c)
+{
+	float t1x0y0;
+	MATERIAL_STENCIL(float, t1x0y0, current[centreIdx], previous[centreIdx], type, width, c, OPEN_NEIGHBOUR);
+	return t1x0y0;
+}
+
+//Persistent fdtdKernel - Launched as a single work-group that loops over every sample of the buffer, so one launch replaces numSteps of them.//
+//With only one group in flight, barriers are enough to order the steps, and connections can be applied after each step without a second pass.//
+__kernel
+void fdtdPersistentKernel(__global int* idGrid, __global float* modelGrid, __global float* boundaryGrid, int idxRotate, int idxSample, int numSteps, __global float* input, __global float* output, int inputPosition, int outputPosition, __global int* materialTypes, __global float* materialCoefficients, int numMaterials, int radius, int width, int height, int numConnections, __global int* connections, __local float* localGrid, __local float* localPrevious)
+{
+	int gridSize = width * height;
+	int localIdx = get_local_id(0);
+	int localSize = get_local_size(0);
+
+#ifdef RESIDENT_LEVELS
+	//Current and previous levels live in local memory. Each step overwrites the previous level in place, as only its own work-item reads it//
+	for (int i = localIdx; i < gridSize; i += localSize)
+	{
+		localGrid[i] = modelGrid[gridSize * rem(idxRotate, 3) + i];
+		localPrevious[i] = modelGrid[gridSize * rem(idxRotate - 1, 3) + i];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	__local float* current = localGrid;
+	__local float* previous = localPrevious;
+	__local float* next = localPrevious;
+#endif
+
+	for (int step = 0; step != numSteps; ++step)
+	{
+#ifndef RESIDENT_LEVELS
+		__global float* current = modelGrid + gridSize * rem(idxRotate + step, 3);
+		__global float* previous = modelGrid + gridSize * rem(idxRotate + step - 1, 3);
+		__global float* next = modelGrid + gridSize * rem(idxRotate + step + 1, 3);
+#endif
+		//Listener reads the current level before the step advances it//
+		if (localIdx == 0 && outputPosition >= 0 && outputPosition < gridSize)
+			output[idxSample + step] = current[outputPosition];
+
+		for (int centreIdx = localIdx; centreIdx < gridSize; centreIdx += localSize)
+		{
+			int x = centreIdx % width;
+			int y = centreIdx / width;
+			int id = idGrid[centreIdx];
+			int type = id > 0 && id < numMaterials ? materialTypes[id] : 0;
+
+			//Cells within radius of the grid edge are never updated, as in fdtdKernel//
+			float t1x0y0 = 0.0f;
+			if (type != 0 && x >= radius && x < width - radius && y >= radius && y < height - radius)
+				t1x0y0 = materialUpdate(current, previous, boundaryGrid, centreIdx, width, type, materialCoefficients + id * NUM_COEFFICIENTS);
+
+			if (centreIdx == inputPosition)
+				t1x0y0 += input[idxSample + step];
+
+			next[centreIdx] = t1x0y0;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+
+		//Couple regions - connections holds (source, destination) pairs. Applied serially as destinations may repeat//
+		if (numConnections > 0)
+		{
+			if (localIdx == 0)
+			{
+				for (int i = 0; i + 1 < numConnections; i += 2)
+					next[connections[i + 1]] += current[connections[i]];
+			}
+			barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+		}
+
+#ifdef RESIDENT_LEVELS
+		next = current;
+		current = previous;
+		previous = next;
+#endif
+	}
+
+#ifdef RESIDENT_LEVELS
+	//Hand the two newest levels back to modelGrid at the slots the rotation index expects//
+	for (int i = localIdx; i < gridSize; i += localSize)
+	{
+		modelGrid[gridSize * rem(idxRotate + numSteps, 3) + i] = current[i];
+		modelGrid[gridSize * rem(idxRotate + numSteps - 1, 3) + i] = previous[i];
+	}
+#endif
+}
@@ -0,0 +1,102 @@
+//Storage of the pressure levels, chosen at build time - -DSTORAGE_HALF keeps 16 bits per cell through vload_half/vstore_half, which need no extension,//
+//-DSTORAGE_DOUBLE 64 bits. Updates compute in real, float unless -DCOMPUTE_DOUBLE. Either double needs cl_khr_fp64//
+#if defined(STORAGE_DOUBLE) || defined(COMPUTE_DOUBLE)
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+#endif
+#ifdef COMPUTE_DOUBLE
+typedef double real;
+#else
+typedef float real;
+#endif
+#if defined(STORAGE_HALF)
+typedef half storage;
+#define LOAD(p, i) ((real)vload_half((i), (p)))
+#define STORE(v, p, i) vstore_half((float)(v), (i), (p))
+#elif defined(STORAGE_DOUBLE)
+typedef double storage;
+#define LOAD(p, i) ((real)(p)[i])
+#define STORE(v, p, i) ((p)[i] = (storage)(v))
+#else
+typedef float storage;
+#define LOAD(p, i) ((real)(p)[i])
+#define STORE(v, p, i) ((p)[i] = (storage)(v))
+#endif
+
+//Storage of the id grid, chosen at build time - 32 bit ints by default, -DID_UCHAR for 8 bits per cell and -DID_IMAGE for a CL_R, CL_UNSIGNED_INT8//
+//image read through the texture cache. The id, boundary and material grids never change after createModel(), so all are const and restrict//
+#if defined(ID_IMAGE)
+typedef __read_only image2d_t id_grid;
+__constant sampler_t idSampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
+#define LOAD_ID(grid, x, y, i) ((int)read_imageui((grid), idSampler, (int2)((x), (y))).x)
+#elif defined(ID_UCHAR)
+typedef __global const uchar* restrict id_grid;
+#define LOAD_ID(grid, x, y, i) ((int)(grid)[i])
+#else
+typedef __global const int* restrict id_grid;
+#define LOAD_ID(grid, x, y, i) ((grid)[i])
+#endif
+
+//Neighbours are weighted by (1-boundaryGrid), a float load each, unless built with -DNEIGHBOUR_MASK=uchar or ushort. boundaryGrid then holds one mask//
+//per cell, fetched once for every neighbour of the stencil. Boundary weights are all 0 or 1 in that case, so both give the same result//
+#ifdef NEIGHBOUR_MASK
+typedef NEIGHBOUR_MASK boundary;
+#define WEIGHTED(bit, offset) (((mask >> (bit)) & 1) ? LOAD(current, centreIdx + (offset)) : (real)0)
+#else
+typedef float boundary;
+#define WEIGHTED(bit, offset) (LOAD(current, centreIdx + (offset)) * (1 - (real)boundaryGrid[centreIdx + (offset)]))
+#endif
+
+real materialUpdate(__global storage* current, __global storage* previous, __global const boundary* restrict boundaryGrid, int centreIdx, int pitch, int type, __global const float* restrict c)
+{
+	real t0x0y0 = LOAD(current, centreIdx);
+#ifdef NEIGHBOUR_MASK
+	uint mask = boundaryGrid[centreIdx];
+#endif
+
+	real t1x0y0;
+	MATERIAL_STENCIL(real, t1x0y0, t0x0y0, LOAD(previous, centreIdx), type, pitch, c, WEIGHTED);
+	return t1x0y0;
+}
+
+//Pitched fdtdKernel - Rows are pitch cells apart, padded so each starts aligned, and the global range is rounded up to whole work-groups with the extra//
+//work-items returning at once. Ids come sanitised from the host, 0 for empty cells and for the edge margin no update reaches past, so cells need no bounds checks.//
+//Positions are pitched indices, y * pitch + x//
+__kernel
+void fdtdPitchedKernel(id_grid idGrid, __global storage* modelGrid, __global const boundary* restrict boundaryGrid, int idxRotate, int idxSample, __global float* input, __global float* output, int inputPosition, int outputPosition, __global const int* restrict materialTypes, __global const float* restrict materialCoefficients, int width, int height, int pitch)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	if (x >= width || y >= height)
+		return;
+
+	int levelSize = pitch * height;
+	__global storage* current = modelGrid + levelSize * rem(idxRotate, 3);
+	__global storage* previous = modelGrid + levelSize * rem(idxRotate - 1, 3);
+	__global storage* next = modelGrid + levelSize * rem(idxRotate + 1, 3);
+
+	int centreIdx = y * pitch + x;
+	if (centreIdx == outputPosition)
+		output[idxSample] = LOAD(current, centreIdx);
+
+	int id = LOAD_ID(idGrid, x, y, centreIdx);
+	int type = materialTypes[id];
+
+	real t1x0y0 = 0;
+	if (type != 0)
+		t1x0y0 = materialUpdate(current, previous, boundaryGrid, centreIdx, pitch, type, materialCoefficients + id * NUM_COEFFICIENTS);
+
+	if (centreIdx == inputPosition)
+		t1x0y0 += input[idxSample];
+
+	STORE(t1x0y0, next, centreIdx);
+}
+
+//Couples regions after fdtdPitchedKernel's step - connections holds (source, destination) pairs of pitched indices. One work-item, as destinations may repeat//
+__kernel
+void fdtdPitchedConnections(__global storage* modelGrid, int idxRotate, int levelSize, int numConnections, __global int* connections)
+{
+	__global storage* current = modelGrid + levelSize * rem(idxRotate, 3);
+	__global storage* next = modelGrid + levelSize * rem(idxRotate + 1, 3);
+	for (int i = 0; i + 1 < numConnections; i += 2)
+		STORE(LOAD(next, connections[i + 1]) + LOAD(current, connections[i]), next, connections[i + 1]);
+}
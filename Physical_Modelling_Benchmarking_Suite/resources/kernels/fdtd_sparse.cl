@@ -0,0 +1,53 @@
+float materialUpdate(__global float* current, __global float* previous, __global float* boundaryGrid, int centreIdx, int width, int type, __global float* c)
+{
+	float t1x0y0;
+	MATERIAL_STENCIL(float, t1x0y0, current[centreIdx], previous[centreIdx], type, width, c, OPEN_NEIGHBOUR);
+	return t1x0y0;
+}
+
+//Sparse fdtdKernel - One work-item per entry of activeCells rather than per grid cell. Cells left out are empty, so all three levels stay zero there without being written.//
+//The list holds every updating cell plus the excitation cell and connection destinations, whose levels are rewritten each step as in fdtdKernel.//
+//Bucketed lists are sorted by material id and padded with -1 to whole work-groups, so no group mixes update paths//
+__kernel
+void fdtdSparseKernel(__global int* idGrid, __global float* modelGrid, __global float* boundaryGrid, int idxRotate, int idxSample, __global float* input, __global float* output, int inputPosition, int outputPosition, __global int* materialTypes, __global float* materialCoefficients, int numMaterials, int radius, int width, int height, __global int* activeCells, int numActiveCells)
+{
+	int gridSize = width * height;
+	__global float* current = modelGrid + gridSize * rem(idxRotate, 3);
+	__global float* previous = modelGrid + gridSize * rem(idxRotate - 1, 3);
+	__global float* next = modelGrid + gridSize * rem(idxRotate + 1, 3);
+
+	//The listener may sit on an empty cell, so it is read by the first work-item rather than the cell's own//
+	int activeIdx = get_global_id(0);
+	if (activeIdx == 0 && outputPosition >= 0 && outputPosition < gridSize)
+		output[idxSample] = current[outputPosition];
+
+	if (activeIdx >= numActiveCells)
+		return;
+	int centreIdx = activeCells[activeIdx];
+	if (centreIdx < 0)
+		return;
+
+	int x = centreIdx % width;
+	int y = centreIdx / width;
+	int id = idGrid[centreIdx];
+	int type = id > 0 && id < numMaterials ? materialTypes[id] : 0;
+
+	float t1x0y0 = 0.0f;
+	if (type != 0 && x >= radius && x < width - radius && y >= radius && y < height - radius)
+		t1x0y0 = materialUpdate(current, previous, boundaryGrid, centreIdx, width, type, materialCoefficients + id * NUM_COEFFICIENTS);
+
+	if (centreIdx == inputPosition)
+		t1x0y0 += input[idxSample];
+
+	next[centreIdx] = t1x0y0;
+}
+
+//Couples regions after fdtdSparseKernel's step - connections holds (source, destination) pairs. One work-item, as destinations may repeat//
+__kernel
+void fdtdSparseConnections(__global float* modelGrid, int idxRotate, int gridSize, int numConnections, __global int* connections)
+{
+	__global float* current = modelGrid + gridSize * rem(idxRotate, 3);
+	__global float* next = modelGrid + gridSize * rem(idxRotate + 1, 3);
+	for (int i = 0; i + 1 < numConnections; i += 2)
+		next[connections[i + 1]] += current[connections[i]];
+}
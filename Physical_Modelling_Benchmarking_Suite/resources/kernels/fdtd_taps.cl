@@ -0,0 +1,23 @@
+//Multi-tap I/O, run after each step's update so it sees the finished next level. taps holds the input taps, then the output taps, then the input taps on cells//
+//no update writes, which are zeroed before their excitation is added. Taps off the grid read 0 and take nothing. Samples are interleaved, [idxSample * numTaps + tap].//
+//One work-item, as taps are few and may share a cell//
+__kernel
+void fdtdTapKernel(__global float* modelGrid, int idxRotate, int idxSample, int gridSize, __global int* taps, int numInputs, int numOutputs, int numClearCells, __global float* inputs, __global float* outputs)
+{
+	__global float* current = modelGrid + gridSize * rem(idxRotate, 3);
+	__global float* next = modelGrid + gridSize * rem(idxRotate + 1, 3);
+	__global int* outputTaps = taps + numInputs;
+	__global int* clearCells = outputTaps + numOutputs;
+
+	for (int i = 0; i != numOutputs; ++i)
+		outputs[idxSample * numOutputs + i] = outputTaps[i] >= 0 && outputTaps[i] < gridSize ? current[outputTaps[i]] : 0.0f;
+
+	for (int i = 0; i != numClearCells; ++i)
+		next[clearCells[i]] = 0.0f;
+
+	for (int i = 0; i != numInputs; ++i)
+	{
+		if (taps[i] >= 0 && taps[i] < gridSize)
+			next[taps[i]] += inputs[idxSample * numInputs + i];
+	}
+}
@@ -0,0 +1,98 @@
+//Temporally blocked fdtdKernel - Each work-group loads its tile plus a halo radius*numSteps cells deep into local memory, then advances numSteps time steps without leaving the group.//
+//Halo cells are recomputed redundantly by neighbouring groups rather than exchanged through global memory, so groups never synchronise with each other.//
+//Results go to modelGridBack, as other groups may still be reading their halo from modelGrid. The host swaps the two afterwards.//
+//Open fractions are kept in localOpen, loaded once per tile//
+#define LOCAL_NEIGHBOUR(bit, offset) (current[i + (offset)] * localOpen[i + (offset)])
+
+__kernel
+void fdtdBlockedKernel(__global int* idGrid, __global float* modelGrid, __global float* modelGridBack, __global float* boundaryGrid, int idxRotate, int idxSample, int numSteps, __global float* input, __global float* output, int inputPosition, int outputPosition, __global int* materialTypes, __global float* materialCoefficients, int numMaterials, int radius, int width, int height, __local float* localGrid, __local float* localPrevious, __local float* localOpen, __local int* localIds)
+{
+	int tileWidth = get_local_size(0);
+	int tileHeight = get_local_size(1);
+	int halo = radius * numSteps;
+	int regionWidth = tileWidth + 2 * halo;
+	int regionHeight = tileHeight + 2 * halo;
+	int regionSize = regionWidth * regionHeight;
+	int originX = get_group_id(0) * tileWidth - halo;
+	int originY = get_group_id(1) * tileHeight - halo;
+	int localIdx = get_local_id(1) * tileWidth + get_local_id(0);
+	int localSize = tileWidth * tileHeight;
+
+	//Rotation Index into model grid//
+	int gridSize = width * height;
+	int rotation0 = gridSize * rem(idxRotate, 3);
+	int rotationM1 = gridSize * rem(idxRotate - 1, 3);
+
+	//Load tile and halo. Cells outside the grid are closed, and cells within radius of the grid edge are never updated, as in fdtdKernel//
+	for (int i = localIdx; i < regionSize; i += localSize)
+	{
+		int x = originX + i % regionWidth;
+		int y = originY + i / regionWidth;
+		int isInside = x >= 0 && x < width && y >= 0 && y < height;
+		int isUpdated = x >= radius && x < width - radius && y >= radius && y < height - radius;
+		int centreIdx = y * width + x;
+
+		localGrid[i] = isInside ? modelGrid[rotation0 + centreIdx] : 0.0f;
+		localPrevious[i] = isInside ? modelGrid[rotationM1 + centreIdx] : 0.0f;
+		localOpen[i] = isInside ? 1.0f - boundaryGrid[centreIdx] : 0.0f;
+
+		int id = isUpdated ? idGrid[centreIdx] : 0;
+		localIds[i] = id > 0 && id < numMaterials ? id : 0;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	__local float* current = localGrid;
+	__local float* previous = localPrevious;
+
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int isOwned = x < width && y < height;
+	int ownedIdx = (get_local_id(1) + halo) * regionWidth + get_local_id(0) + halo;
+
+	for (int step = 0; step != numSteps; ++step)
+	{
+		//Only the group owning the listener reads it, before the step advances it//
+		if (isOwned && y * width + x == outputPosition)
+			output[idxSample + step] = current[ownedIdx];
+
+		for (int i = localIdx; i < regionSize; i += localSize)
+		{
+			int regionX = i % regionWidth;
+			int regionY = i / regionWidth;
+
+			//Outermost ring has no neighbours loaded - Its value goes stale, but it lies outside what the remaining steps need//
+			if (regionX < radius || regionY < radius || regionX >= regionWidth - radius || regionY >= regionHeight - radius)
+				continue;
+
+			float t1x0y0 = 0.0f;
+			int id = localIds[i];
+			int type = materialTypes[id];
+			if (id != 0 && type != 0)
+			{
+				__global float* c = materialCoefficients + id * NUM_COEFFICIENTS;
+				MATERIAL_STENCIL(float, t1x0y0, current[i], previous[i], type, regionWidth, c, LOCAL_NEIGHBOUR);
+			}
+
+			//Every group holding the excitation cell applies it, so halo copies stay identical to the owner's//
+			int globalX = originX + regionX;
+			int globalY = originY + regionY;
+			if (globalX >= 0 && globalX < width && globalY >= 0 && globalY < height && globalY * width + globalX == inputPosition)
+				t1x0y0 += input[idxSample + step];
+
+			//previous[i] is only ever read by this work-item, so the next level can overwrite it in place//
+			previous[i] = t1x0y0;
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		__local float* swap = current;
+		current = previous;
+		previous = swap;
+	}
+
+	if (isOwned)
+	{
+		int centreIdx = y * width + x;
+		modelGridBack[gridSize * rem(idxRotate + numSteps, 3) + centreIdx] = current[ownedIdx];
+		modelGridBack[gridSize * rem(idxRotate + numSteps - 1, 3) + centreIdx] = previous[ownedIdx];
+	}
+}